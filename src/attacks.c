@@ -0,0 +1,256 @@
+#include "attacks.h"
+
+bitboard_t knight_attacks[SQUARE_COUNT];
+bitboard_t king_attacks[SQUARE_COUNT];
+bitboard_t pawn_attacks[COLOR_COUNT][SQUARE_COUNT];
+bitboard_t between_bb[SQUARE_COUNT][SQUARE_COUNT];
+bitboard_t line_bb[SQUARE_COUNT][SQUARE_COUNT];
+
+magic_t bishop_magics[SQUARE_COUNT];
+magic_t rook_magics[SQUARE_COUNT];
+
+// Shared attack tables; each square owns 2^(relevant bits) consecutive slots
+static bitboard_t bishop_table[5248];
+static bitboard_t rook_table[102400];
+
+// Rays from each square in the eight directions, excluding the square itself.
+// The first four directions increase the square index, the last four
+// decrease it, which decides whether the nearest blocker is the lowest or the
+// highest bit of the ray.
+enum { DIR_E, DIR_S, DIR_SE, DIR_SW, DIR_W, DIR_N, DIR_NW, DIR_NE, DIR_COUNT };
+
+static const int ray_offsets[DIR_COUNT][2] = {
+    {0, 1}, {1, 0}, {1, 1}, {1, -1}, {0, -1}, {-1, 0}, {-1, -1}, {-1, 1}};
+
+static bitboard_t rays[DIR_COUNT][SQUARE_COUNT];
+
+static bitboard_t offsets_to_bb(int square, const int offsets[][2],
+                                int count) {
+  bitboard_t bb = 0;
+  int row = square_row(square);
+  int col = square_col(square);
+
+  for (int i = 0; i < count; i++) {
+    int r = row + offsets[i][0];
+    int c = col + offsets[i][1];
+    if (is_valid_position(r, c)) {
+      bb |= square_bb(make_square(r, c));
+    }
+  }
+  return bb;
+}
+
+static void init_slider_attacks(void);
+
+void init_attacks(void) {
+  static int initialized = 0;
+  if (initialized)
+    return;
+  initialized = 1;
+
+  static const int knight_offsets[8][2] = {{-2, -1}, {-2, 1}, {-1, -2},
+                                           {-1, 2},  {1, -2}, {1, 2},
+                                           {2, -1},  {2, 1}};
+  static const int king_offsets[8][2] = {{-1, -1}, {-1, 0}, {-1, 1}, {0, -1},
+                                         {0, 1},   {1, -1}, {1, 0},  {1, 1}};
+  // White moves up the board (towards row 0), black moves down
+  static const int white_pawn_offsets[2][2] = {{-1, -1}, {-1, 1}};
+  static const int black_pawn_offsets[2][2] = {{1, -1}, {1, 1}};
+
+  for (int sq = 0; sq < SQUARE_COUNT; sq++) {
+    knight_attacks[sq] = offsets_to_bb(sq, knight_offsets, 8);
+    king_attacks[sq] = offsets_to_bb(sq, king_offsets, 8);
+    pawn_attacks[NONE][sq] = 0;
+    pawn_attacks[WHITE][sq] = offsets_to_bb(sq, white_pawn_offsets, 2);
+    pawn_attacks[BLACK][sq] = offsets_to_bb(sq, black_pawn_offsets, 2);
+
+    for (int d = 0; d < DIR_COUNT; d++) {
+      bitboard_t ray = 0;
+      int r = square_row(sq) + ray_offsets[d][0];
+      int c = square_col(sq) + ray_offsets[d][1];
+      while (is_valid_position(r, c)) {
+        ray |= square_bb(make_square(r, c));
+        r += ray_offsets[d][0];
+        c += ray_offsets[d][1];
+      }
+      rays[d][sq] = ray;
+    }
+  }
+
+  // Directions d and d + 4 point opposite ways
+  for (int sq = 0; sq < SQUARE_COUNT; sq++) {
+    for (int d = 0; d < DIR_COUNT; d++) {
+      bitboard_t ray = rays[d][sq];
+      bitboard_t line = ray | rays[(d + 4) % DIR_COUNT][sq] | square_bb(sq);
+      while (ray) {
+        int target = pop_lsb(&ray);
+        between_bb[sq][target] =
+            rays[d][sq] & ~rays[d][target] & ~square_bb(target);
+        line_bb[sq][target] = line;
+      }
+    }
+  }
+
+  init_slider_attacks();
+}
+
+// Attacks along one ray, cut off behind the first blocker. Only used to fill
+// the magic tables at startup.
+static bitboard_t ray_attacks(int dir, int square, bitboard_t occupied) {
+  bitboard_t ray = rays[dir][square];
+  bitboard_t blockers = ray & occupied;
+  if (!blockers) {
+    return ray;
+  }
+
+  int blocker = (dir < DIR_W) ? lsb(blockers) : msb(blockers);
+  return ray & ~rays[dir][blocker];
+}
+
+static bitboard_t slow_slider_attacks(const int *dirs, int square,
+                                      bitboard_t occupied) {
+  bitboard_t attacks = 0;
+  for (int i = 0; i < 4; i++) {
+    attacks |= ray_attacks(dirs[i], square, occupied);
+  }
+  return attacks;
+}
+
+// Squares whose occupancy can change the attack set: the rays without their
+// last square, since a piece on the board edge never blocks anything behind it
+static bitboard_t relevant_mask(const int *dirs, int square) {
+  bitboard_t mask = 0;
+  for (int i = 0; i < 4; i++) {
+    bitboard_t ray = rays[dirs[i]][square];
+    if (ray) {
+      int edge = (dirs[i] < DIR_W) ? msb(ray) : lsb(ray);
+      mask |= ray & ~square_bb(edge);
+    }
+  }
+  return mask;
+}
+
+// Magic multipliers, found once by a random search over sparse 64-bit numbers
+// and verified to map every blocker subset without destructive collisions
+static const bitboard_t bishop_magic_numbers[SQUARE_COUNT] = {
+    0x10102002004A1420ULL, 0x8020040400584008ULL, 0x10510800811201C8ULL,
+    0x5204042080000088ULL, 0x2204106880000002ULL, 0x1401042004000000ULL,
+    0x0400880410042004ULL, 0x0028208200A02020ULL, 0x1500241990010E00ULL,
+    0x8001200182020A40ULL, 0x40004101030B0000ULL, 0x8002041042000100ULL,
+    0x4010011041020038ULL, 0x0000010421044000ULL, 0x1500210808020A00ULL,
+    0x8000088400880520ULL, 0x0405004010040100ULL, 0x1005823210040108ULL,
+    0x2708008102040011ULL, 0x4048200404009100ULL, 0x0018104101400024ULL,
+    0x0003000601190101ULL, 0x8004803108491000ULL, 0x8014241200820800ULL,
+    0x0006E080100C3040ULL, 0x0501044A11041800ULL, 0x9020300008004045ULL,
+    0x0894080000220040ULL, 0x1001010083104000ULL, 0x5004030040900080ULL,
+    0x000400422C012400ULL, 0x0002128698404812ULL, 0x1010108404900440ULL,
+    0x0928021182084100ULL, 0x2006080409020024ULL, 0x1010202020180080ULL,
+    0xA010008200202200ULL, 0x2098015100019004ULL, 0x0002041440810811ULL,
+    0x802A02020000B098ULL, 0x0009015090004060ULL, 0x4000821082081001ULL,
+    0x0100210040420800ULL, 0x0800004010488A00ULL, 0x2000081104004040ULL,
+    0x4C8E029015000082ULL, 0x0420340322224842ULL, 0x1298260043400210ULL,
+    0x0000822802400008ULL, 0x00008A0101600000ULL, 0x3040003412080021ULL,
+    0x3040290220884800ULL, 0x4A1500401041004AULL, 0x8010200282020781ULL,
+    0x0020203142209091ULL, 0x0070300600902110ULL, 0x0040808800B62048ULL,
+    0x0000810400C44420ULL, 0x00080400440C0441ULL, 0x8340080020840411ULL,
+    0x0000000104208200ULL, 0x0000800810D00080ULL, 0x0400530411080200ULL,
+    0x4040702400932244ULL,
+};
+
+static const bitboard_t rook_magic_numbers[SQUARE_COUNT] = {
+    0x1080004008801020ULL, 0x0840092002C03000ULL, 0x1900200010400900ULL,
+    0x0880100008000480ULL, 0x4200100420080200ULL, 0x8100020100080400ULL,
+    0x0200040110886200ULL, 0x0200008040220411ULL, 0x0404800084400220ULL,
+    0x0000401000402000ULL, 0x0086001081220440ULL, 0x0408800800100280ULL,
+    0x000A001201040820ULL, 0x8848800200840080ULL, 0x4001000100040200ULL,
+    0x0442000102105084ULL, 0x9080010020804100ULL, 0x0040404000201009ULL,
+    0x0000808010002009ULL, 0x2200090021D00100ULL, 0x0008008008040080ULL,
+    0x0004004002010040ULL, 0x0011040008015042ULL, 0x00000A0001768104ULL,
+    0x0000800080204009ULL, 0x2010004140002001ULL, 0x9800200280100080ULL,
+    0x1000100080080080ULL, 0x0442000A00049020ULL, 0x2100040080020080ULL,
+    0x0800120400900148ULL, 0x0010040A00128541ULL, 0x2800804000800030ULL,
+    0x1010002000400041ULL, 0x4000200011004100ULL, 0x0610008410800800ULL,
+    0x0400802402800800ULL, 0xC100020080800400ULL, 0x0002000802000401ULL,
+    0x0182085882000401ULL, 0x0220204000808000ULL, 0x2860100040024022ULL,
+    0x0001002004110040ULL, 0x99101042000A0020ULL, 0x0004080004008080ULL,
+    0x0010040002008080ULL, 0x2012004881020004ULL, 0x8300842444820011ULL,
+    0x0088403882010200ULL, 0x0820400080210100ULL, 0x0110910040A00300ULL,
+    0x0801100280080480ULL, 0x0242009008200600ULL, 0x1002000489500200ULL,
+    0x0040800200010080ULL, 0x0091800041000080ULL, 0x0000209300488001ULL,
+    0x04C1002414824001ULL, 0x020020000B001041ULL, 0x7000100004200901ULL,
+    0x8002002004100802ULL, 0x30010002084C0007ULL, 0x0888221800813004ULL,
+    0x4000002840840112ULL,
+};
+
+// Fill the attack table of every square for one slider. With PEXT the index
+// is the occupancy compressed through the mask, otherwise it comes from the
+// magic multiplier of the square.
+static void init_magics(magic_t magics[SQUARE_COUNT], bitboard_t *table,
+                        const bitboard_t *magic_numbers, const int *dirs) {
+  bitboard_t *next = table;
+
+  for (int sq = 0; sq < SQUARE_COUNT; sq++) {
+    magic_t *m = &magics[sq];
+    m->mask = relevant_mask(dirs, sq);
+    m->magic = magic_numbers[sq];
+    m->shift = 64 - popcount(m->mask);
+    m->attacks = next;
+
+    // Enumerate every subset of the mask (Carry-Rippler)
+    int size = 0;
+    bitboard_t subset = 0;
+    do {
+      m->attacks[magic_index(m, subset)] =
+          slow_slider_attacks(dirs, sq, subset);
+      size++;
+      subset = (subset - m->mask) & m->mask;
+    } while (subset);
+    next += size;
+  }
+}
+
+static void init_slider_attacks(void) {
+  static const int bishop_dirs[4] = {DIR_SE, DIR_SW, DIR_NW, DIR_NE};
+  static const int rook_dirs[4] = {DIR_E, DIR_S, DIR_W, DIR_N};
+
+  init_magics(bishop_magics, bishop_table, bishop_magic_numbers, bishop_dirs);
+  init_magics(rook_magics, rook_table, rook_magic_numbers, rook_dirs);
+}
+
+// Work outwards from the target: a piece attacks the square exactly when the
+// same kind of piece placed on the square would attack it back (with the pawn
+// direction reversed).
+bitboard_t attackers_to(const board_t *board, int square, bitboard_t occupied) {
+  bitboard_t knights =
+      board->pieces[WHITE][KNIGHT] | board->pieces[BLACK][KNIGHT];
+  bitboard_t kings = board->pieces[WHITE][KING] | board->pieces[BLACK][KING];
+  bitboard_t queens = board->pieces[WHITE][QUEEN] | board->pieces[BLACK][QUEEN];
+  bitboard_t diagonal =
+      board->pieces[WHITE][BISHOP] | board->pieces[BLACK][BISHOP] | queens;
+  bitboard_t straight =
+      board->pieces[WHITE][ROOK] | board->pieces[BLACK][ROOK] | queens;
+
+  return (pawn_attacks[BLACK][square] & board->pieces[WHITE][PAWN]) |
+         (pawn_attacks[WHITE][square] & board->pieces[BLACK][PAWN]) |
+         (knight_attacks[square] & knights) | (king_attacks[square] & kings) |
+         (bishop_attacks(square, occupied) & diagonal) |
+         (rook_attacks(square, occupied) & straight);
+}
+
+int is_square_attacked(const board_t *board, int square, int attacking_color) {
+  const bitboard_t *pieces = board->pieces[attacking_color];
+  bitboard_t occupied = board->occupied[NONE];
+
+  // Cheapest lookups first, sliders only if nothing else attacks
+  if (pawn_attacks[opponent_of(attacking_color)][square] & pieces[PAWN])
+    return 1;
+  if (knight_attacks[square] & pieces[KNIGHT])
+    return 1;
+  if (king_attacks[square] & pieces[KING])
+    return 1;
+  if (bishop_attacks(square, occupied) & (pieces[BISHOP] | pieces[QUEEN]))
+    return 1;
+  if (rook_attacks(square, occupied) & (pieces[ROOK] | pieces[QUEEN]))
+    return 1;
+  return 0;
+}
@@ -0,0 +1,71 @@
+#ifndef ATTACKS_H
+#define ATTACKS_H
+
+#include "bitboard.h"
+#include "board.h"
+
+// Sliding attacks are looked up in tables indexed by the occupancy of the
+// squares that can block the slider. On CPUs with BMI2 the index is a single
+// PEXT; elsewhere it is the classic magic multiply-and-shift. PEXT is slow on
+// some older AMD chips, build with -DNO_PEXT there.
+#if defined(__BMI2__) && !defined(NO_PEXT)
+#include <immintrin.h>
+#define USE_PEXT
+#endif
+
+typedef struct {
+  bitboard_t mask;     // Relevant blocker squares, board edges excluded
+  bitboard_t magic;    // Unused with PEXT
+  bitboard_t *attacks; // Slice of the shared attack table for this square
+  int shift;
+} magic_t;
+
+// Precomputed attack sets for the non-sliding pieces
+extern bitboard_t knight_attacks[SQUARE_COUNT];
+extern bitboard_t king_attacks[SQUARE_COUNT];
+extern bitboard_t pawn_attacks[COLOR_COUNT][SQUARE_COUNT]; // [color][square]
+
+// Squares strictly between two aligned squares, and the full line through
+// them (edge to edge). Both are empty when the squares are not aligned.
+extern bitboard_t between_bb[SQUARE_COUNT][SQUARE_COUNT];
+extern bitboard_t line_bb[SQUARE_COUNT][SQUARE_COUNT];
+
+extern magic_t bishop_magics[SQUARE_COUNT];
+extern magic_t rook_magics[SQUARE_COUNT];
+
+// Must be called once before any attack lookup
+void init_attacks(void);
+
+static inline unsigned magic_index(const magic_t *m, bitboard_t occupied) {
+#ifdef USE_PEXT
+  return (unsigned)_pext_u64(occupied, m->mask);
+#else
+  return (unsigned)(((occupied & m->mask) * m->magic) >> m->shift);
+#endif
+}
+
+// Sliding attacks from square given the set of occupied squares. The first
+// blocker on each ray is included, whatever its color.
+static inline bitboard_t bishop_attacks(int square, bitboard_t occupied) {
+  const magic_t *m = &bishop_magics[square];
+  return m->attacks[magic_index(m, occupied)];
+}
+
+static inline bitboard_t rook_attacks(int square, bitboard_t occupied) {
+  const magic_t *m = &rook_magics[square];
+  return m->attacks[magic_index(m, occupied)];
+}
+
+static inline bitboard_t queen_attacks(int square, bitboard_t occupied) {
+  return bishop_attacks(square, occupied) | rook_attacks(square, occupied);
+}
+
+// All pieces of either color attacking square. Sliders are resolved against
+// occupied rather than the board, so callers can remove pieces (x-rays,
+// exchange sequences) without touching the board.
+bitboard_t attackers_to(const board_t *board, int square, bitboard_t occupied);
+
+// Whether any piece of attacking_color attacks square
+int is_square_attacked(const board_t *board, int square, int attacking_color);
+
+#endif // ATTACKS_H
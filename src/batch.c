@@ -0,0 +1,375 @@
+#include "batch.h"
+#include "attacks.h"
+#include "pawns.h"
+#include "psqt.h"
+#include <string.h>
+
+// The kernels below are written once against a small set of lane
+// operations. With AVX2 a lane group is a register of four boards' bitboards;
+// otherwise it is a plain bitboard and the groups are single boards.
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define USE_AVX2
+#endif
+
+#ifdef USE_AVX2
+#define LANES 4
+typedef __m256i lanes_t;
+
+static inline lanes_t load_lanes(const bitboard_t *p) {
+  return _mm256_loadu_si256((const __m256i *)p);
+}
+static inline void store_lanes(bitboard_t *p, lanes_t v) {
+  _mm256_storeu_si256((__m256i *)p, v);
+}
+static inline lanes_t broadcast(bitboard_t bb) {
+  return _mm256_set1_epi64x((long long)bb);
+}
+static inline lanes_t and_lanes(lanes_t a, lanes_t b) {
+  return _mm256_and_si256(a, b);
+}
+static inline lanes_t or_lanes(lanes_t a, lanes_t b) {
+  return _mm256_or_si256(a, b);
+}
+static inline lanes_t andnot_lanes(lanes_t a, lanes_t b) { // a & ~b
+  return _mm256_andnot_si256(b, a);
+}
+static inline lanes_t shl_lanes(lanes_t a, int n) {
+  return _mm256_slli_epi64(a, n);
+}
+static inline lanes_t shr_lanes(lanes_t a, int n) {
+  return _mm256_srli_epi64(a, n);
+}
+static inline lanes_t lowest_lanes(lanes_t a) { // a & -a
+  return _mm256_and_si256(a, _mm256_sub_epi64(_mm256_setzero_si256(), a));
+}
+static inline int lanes_empty(lanes_t a) { return _mm256_testz_si256(a, a); }
+#else
+#define LANES 1
+typedef bitboard_t lanes_t;
+
+static inline lanes_t load_lanes(const bitboard_t *p) { return *p; }
+static inline void store_lanes(bitboard_t *p, lanes_t v) { *p = v; }
+static inline lanes_t broadcast(bitboard_t bb) { return bb; }
+static inline lanes_t and_lanes(lanes_t a, lanes_t b) { return a & b; }
+static inline lanes_t or_lanes(lanes_t a, lanes_t b) { return a | b; }
+static inline lanes_t andnot_lanes(lanes_t a, lanes_t b) { return a & ~b; }
+static inline lanes_t shl_lanes(lanes_t a, int n) { return a << n; }
+static inline lanes_t shr_lanes(lanes_t a, int n) { return a >> n; }
+static inline lanes_t lowest_lanes(lanes_t a) { return a & (0 - a); }
+static inline int lanes_empty(lanes_t a) { return a == 0; }
+#endif
+
+#define COL_B (COL_A << 1)
+#define COL_G (COL_H >> 1)
+
+// Move every bit by offset squares, towards higher squares if positive
+static inline lanes_t move_lanes(lanes_t bb, int offset) {
+  return (offset > 0) ? shl_lanes(bb, offset) : shr_lanes(bb, -offset);
+}
+
+// The same, dropping the bits that land outside mask (those that wrapped
+// around the board edge)
+static inline lanes_t shift_lanes(lanes_t bb, int offset, bitboard_t mask) {
+  return and_lanes(move_lanes(bb, offset), broadcast(mask));
+}
+
+/// Attacks
+// The eight directions as a square offset and the columns a step may land
+// on without having wrapped around the board edge
+typedef struct {
+  int offset;
+  bitboard_t mask;
+} direction_t;
+
+static const direction_t orthogonal[4] = {
+    {-8, ~0ULL}, {8, ~0ULL}, {1, ~COL_A}, {-1, ~COL_H}};
+static const direction_t diagonal[4] = {
+    {-7, ~COL_A}, {-9, ~COL_H}, {9, ~COL_A}, {7, ~COL_H}};
+
+// Kogge-Stone occluded fill: the squares sliders attack in one direction,
+// in three doubling steps instead of one step per square
+static inline lanes_t slide(lanes_t sliders, lanes_t empty,
+                            const direction_t *d) {
+  lanes_t propagate = and_lanes(empty, broadcast(d->mask));
+  lanes_t generate = sliders;
+  for (int step = d->offset; step != 4 * d->offset; step *= 2) {
+    generate =
+        or_lanes(generate, and_lanes(propagate, move_lanes(generate, step)));
+    propagate = and_lanes(propagate, move_lanes(propagate, step));
+  }
+  generate = or_lanes(generate,
+                      and_lanes(propagate, move_lanes(generate, 4 * d->offset)));
+  return shift_lanes(generate, d->offset, d->mask);
+}
+
+static inline lanes_t slider_attacks(lanes_t sliders, lanes_t empty,
+                                     const direction_t directions[4]) {
+  lanes_t attacks = broadcast(0);
+  for (int i = 0; i < 4; i++) {
+    attacks = or_lanes(attacks, slide(sliders, empty, &directions[i]));
+  }
+  return attacks;
+}
+
+#ifdef USE_AVX2
+static inline lanes_t diagonal_attacks(lanes_t sliders, lanes_t empty) {
+  return slider_attacks(sliders, empty, diagonal);
+}
+
+static inline lanes_t orthogonal_attacks(lanes_t sliders, lanes_t empty) {
+  return slider_attacks(sliders, empty, orthogonal);
+}
+#else
+// One board at a time, the magic lookups are cheaper than the fills
+static inline lanes_t diagonal_attacks(lanes_t sliders, lanes_t empty) {
+  bitboard_t attacks = 0;
+  while (sliders) {
+    attacks |= bishop_attacks(pop_lsb(&sliders), ~empty);
+  }
+  return attacks;
+}
+
+static inline lanes_t orthogonal_attacks(lanes_t sliders, lanes_t empty) {
+  bitboard_t attacks = 0;
+  while (sliders) {
+    attacks |= rook_attacks(pop_lsb(&sliders), ~empty);
+  }
+  return attacks;
+}
+#endif
+
+static inline lanes_t knights_attacks(lanes_t knights) {
+  static const direction_t jumps[8] = {
+      {17, ~COL_A},          {15, ~COL_H},          {10, ~(COL_A | COL_B)},
+      {6, ~(COL_G | COL_H)}, {-17, ~COL_H},         {-15, ~COL_A},
+      {-10, ~(COL_G | COL_H)}, {-6, ~(COL_A | COL_B)}};
+  lanes_t attacks = broadcast(0);
+  for (int i = 0; i < 8; i++) {
+    attacks =
+        or_lanes(attacks, shift_lanes(knights, jumps[i].offset, jumps[i].mask));
+  }
+  return attacks;
+}
+
+static inline lanes_t kings_attacks(lanes_t kings) {
+  lanes_t attacks = broadcast(0);
+  for (int i = 0; i < 4; i++) {
+    attacks = or_lanes(attacks, shift_lanes(kings, orthogonal[i].offset,
+                                            orthogonal[i].mask));
+    attacks = or_lanes(attacks, shift_lanes(kings, diagonal[i].offset,
+                                            diagonal[i].mask));
+  }
+  return attacks;
+}
+
+/// Pawn geometry, as in pawns.c. White moves toward row 0, the low bits.
+static inline lanes_t forward(lanes_t bb, int color) {
+  return (color == WHITE) ? shr_lanes(bb, 8) : shl_lanes(bb, 8);
+}
+
+static inline lanes_t front_span(lanes_t bb, int color) {
+  bb = forward(bb, color);
+  if (color == WHITE) {
+    bb = or_lanes(bb, shr_lanes(bb, 8));
+    bb = or_lanes(bb, shr_lanes(bb, 16));
+    bb = or_lanes(bb, shr_lanes(bb, 32));
+  } else {
+    bb = or_lanes(bb, shl_lanes(bb, 8));
+    bb = or_lanes(bb, shl_lanes(bb, 16));
+    bb = or_lanes(bb, shl_lanes(bb, 32));
+  }
+  return bb;
+}
+
+static inline lanes_t adjacent_cols(lanes_t bb) {
+  return or_lanes(shift_lanes(bb, 1, ~COL_A), shift_lanes(bb, -1, ~COL_H));
+}
+
+static inline lanes_t pawns_attacks(lanes_t pawns, int color) {
+  return adjacent_cols(forward(pawns, color));
+}
+
+/// Counting
+static inline void count_lanes(lanes_t bb, int out[LANES]) {
+  bitboard_t bits[LANES];
+  store_lanes(bits, bb);
+  for (int lane = 0; lane < LANES; lane++) {
+    out[lane] = popcount(bits[lane]);
+  }
+}
+
+static inline void add_counts(lanes_t bb, int out[LANES]) {
+  int counts[LANES];
+  count_lanes(bb, counts);
+  for (int lane = 0; lane < LANES; lane++) {
+    out[lane] += counts[lane];
+  }
+}
+
+// The pawns.c terms for color, one set operation per term for every pawn
+// of every board in the group
+static void add_pawn_terms(const batch_t *batch, int first, int color,
+                           int mg[LANES], int eg[LANES]) {
+  int them = opponent_of(color);
+  int sign = (color == WHITE) ? 1 : -1;
+  lanes_t ours = load_lanes(&batch->pieces[color][PAWN][first]);
+  lanes_t theirs = load_lanes(&batch->pieces[them][PAWN][first]);
+  lanes_t king = load_lanes(&batch->pieces[color][KING][first]);
+
+  // A pawn is behind one of its own if it is in front of it from the
+  // other side's point of view, and so on for the other terms
+  lanes_t doubled = and_lanes(ours, front_span(ours, them));
+  lanes_t their_spans = front_span(theirs, them);
+  lanes_t passed = andnot_lanes(
+      andnot_lanes(ours, doubled),
+      or_lanes(their_spans, adjacent_cols(their_spans)));
+
+  lanes_t columns = or_lanes(or_lanes(ours, front_span(ours, WHITE)),
+                             front_span(ours, BLACK));
+  lanes_t isolated = andnot_lanes(ours, adjacent_cols(columns));
+  // Squares level with or ahead of a pawn on a neighbouring column
+  lanes_t supportable = or_lanes(adjacent_cols(ours),
+                                 front_span(adjacent_cols(ours), color));
+  lanes_t backward =
+      and_lanes(andnot_lanes(andnot_lanes(ours, isolated), supportable),
+                forward(pawns_attacks(theirs, them), them));
+
+  lanes_t front = forward(or_lanes(king, adjacent_cols(king)), color);
+
+  int doubled_count[LANES], isolated_count[LANES], backward_count[LANES];
+  int shelter_near[LANES], shelter_far[LANES];
+  bitboard_t passers[LANES];
+  count_lanes(doubled, doubled_count);
+  count_lanes(isolated, isolated_count);
+  count_lanes(backward, backward_count);
+  count_lanes(and_lanes(ours, front), shelter_near);
+  count_lanes(and_lanes(ours, forward(front, color)), shelter_far);
+  store_lanes(passers, passed);
+
+  for (int lane = 0; lane < LANES; lane++) {
+    int value[2];
+    for (int phase = PHASE_MG; phase <= PHASE_EG; phase++) {
+      value[phase] = doubled_count[lane] * pawn_doubled[phase] +
+                     isolated_count[lane] * pawn_isolated[phase] +
+                     backward_count[lane] * pawn_backward[phase];
+    }
+    value[PHASE_MG] += shelter_near[lane] * pawn_shelter[0] +
+                       shelter_far[lane] * pawn_shelter[1];
+
+    // Passed pawns are few, so visit them one by one for their ranks
+    bitboard_t bb = passers[lane];
+    while (bb) {
+      int square = pop_lsb(&bb);
+      int rank = (color == WHITE) ? 7 - square_row(square) : square_row(square);
+      value[PHASE_MG] += pawn_passed[PHASE_MG][rank];
+      value[PHASE_EG] += pawn_passed[PHASE_EG][rank];
+    }
+
+    mg[lane] += sign * value[PHASE_MG];
+    eg[lane] += sign * value[PHASE_EG];
+  }
+}
+
+// Add the moves of each piece in pieces, all of one type, to mobility (a
+// square two pieces reach counts twice) and their attacks to attacked.
+// Every board in the group gives up its lowest piece at once, so the loop
+// runs as often as the board with the most such pieces needs.
+static inline void add_mobility(lanes_t pieces, int type, lanes_t empty,
+                                lanes_t own, int mobility[LANES],
+                                lanes_t *attacked) {
+  while (!lanes_empty(pieces)) {
+    lanes_t piece = lowest_lanes(pieces);
+    pieces = andnot_lanes(pieces, piece);
+    lanes_t attacks;
+    if (type == KNIGHT) {
+      attacks = knights_attacks(piece);
+    } else if (type == BISHOP) {
+      attacks = diagonal_attacks(piece, empty);
+    } else if (type == ROOK) {
+      attacks = orthogonal_attacks(piece, empty);
+    } else {
+      attacks = or_lanes(diagonal_attacks(piece, empty),
+                         orthogonal_attacks(piece, empty));
+    }
+    add_counts(andnot_lanes(attacks, own), mobility);
+    *attacked = or_lanes(*attacked, attacks);
+  }
+}
+
+static void evaluate_group(const batch_t *batch, int first,
+                           batch_result_t *result) {
+  lanes_t occupied = broadcast(0);
+  for (int color = WHITE; color <= BLACK; color++) {
+    for (int type = PAWN; type <= KING; type++) {
+      occupied =
+          or_lanes(occupied, load_lanes(&batch->pieces[color][type][first]));
+    }
+  }
+  lanes_t empty = andnot_lanes(broadcast(~0ULL), occupied);
+
+  for (int color = WHITE; color <= BLACK; color++) {
+    const bitboard_t(*pieces)[BATCH_SIZE] = batch->pieces[color];
+    lanes_t own = broadcast(0);
+    for (int type = PAWN; type <= KING; type++) {
+      own = or_lanes(own, load_lanes(&pieces[type][first]));
+    }
+    lanes_t attacks = broadcast(0);
+    int mobility[LANES] = {0};
+    for (int type = KNIGHT; type <= QUEEN; type++) {
+      add_mobility(load_lanes(&pieces[type][first]), type, empty, own,
+                   mobility, &attacks);
+    }
+    memcpy(&result->mobility[color][first], mobility, sizeof(mobility));
+
+    attacks = or_lanes(attacks, pawns_attacks(load_lanes(&pieces[PAWN][first]),
+                                              color));
+    attacks = or_lanes(attacks, kings_attacks(load_lanes(&pieces[KING][first])));
+    store_lanes(&result->attacks[color][first], attacks);
+  }
+
+  int mg[LANES], eg[LANES];
+  for (int lane = 0; lane < LANES; lane++) {
+    mg[lane] = batch->psq_mg[first + lane];
+    eg[lane] = batch->psq_eg[first + lane];
+  }
+  add_pawn_terms(batch, first, WHITE, mg, eg);
+  add_pawn_terms(batch, first, BLACK, mg, eg);
+
+  // Tapered exactly as evaluate() does it
+  for (int lane = 0; lane < LANES; lane++) {
+    int i = first + lane;
+    int phase = batch->phase[i] < PHASE_MAX ? batch->phase[i] : PHASE_MAX;
+    int score = (mg[lane] * phase + eg[lane] * (PHASE_MAX - phase)) / PHASE_MAX;
+    result->eval[i] = (batch->side_to_move[i] == WHITE) ? score : -score;
+  }
+}
+
+/// Public API
+void batch_clear(batch_t *batch) { memset(batch, 0, sizeof(*batch)); }
+
+int batch_add(batch_t *batch, const position_t *pos) {
+  if (batch->count >= BATCH_SIZE)
+    return -1;
+
+  int i = batch->count++;
+  const board_t *board = &pos->board;
+  for (int color = WHITE; color <= BLACK; color++) {
+    for (int type = PAWN; type <= KING; type++) {
+      batch->pieces[color][type][i] = board->pieces[color][type];
+    }
+  }
+  batch->psq_mg[i] = board->psq_mg;
+  batch->psq_eg[i] = board->psq_eg;
+  batch->phase[i] = board->phase;
+  batch->side_to_move[i] = pos->side_to_move;
+  return i;
+}
+
+void batch_evaluate(const batch_t *batch, batch_result_t *result) {
+  // Empty slots are all zero, so they come out as zeros without a special
+  // case
+  for (int first = 0; first < BATCH_SIZE; first += LANES) {
+    evaluate_group(batch, first, result);
+  }
+}
@@ -0,0 +1,42 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include "position.h"
+
+// Attack maps, mobility and static evaluation for many independent
+// positions at once, for data generation and offline analysis. Boards are
+// stored structure of arrays: the same bitboard of every board in the batch
+// sits side by side, so one AVX2 register holds it for four boards and each
+// Kogge-Stone fill slides a piece of every one of them.
+// Without AVX2 the same code runs one board at a time.
+#define BATCH_SIZE 8
+
+typedef struct {
+  _Alignas(32) bitboard_t pieces[COLOR_COUNT][PIECE_TYPE_COUNT][BATCH_SIZE];
+  // Piece-square totals and phase, taken over from the positions' boards
+  int psq_mg[BATCH_SIZE];
+  int psq_eg[BATCH_SIZE];
+  int phase[BATCH_SIZE];
+  int side_to_move[BATCH_SIZE];
+  int count; // Boards in use, the rest are empty
+} batch_t;
+
+typedef struct {
+  bitboard_t attacks[COLOR_COUNT][BATCH_SIZE]; // Every square color attacks
+  // Moves of color's knights, bishops, rooks and queens to squares not
+  // holding own pieces, summed over the pieces
+  int mobility[COLOR_COUNT][BATCH_SIZE];
+  // evaluate() without a network, from the side to move's point of view
+  int eval[BATCH_SIZE];
+} batch_result_t;
+
+void batch_clear(batch_t *batch);
+
+// Copy pos into the next free slot. Returns the slot, or -1 if the batch is
+// full.
+int batch_add(batch_t *batch, const position_t *pos);
+
+// Fill result for every slot; empty slots get zeros
+void batch_evaluate(const batch_t *batch, batch_result_t *result);
+
+#endif // BATCH_H
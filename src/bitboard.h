@@ -0,0 +1,39 @@
+#ifndef BITBOARD_H
+#define BITBOARD_H
+
+#include <stdint.h>
+
+// A bitboard is a set of squares, one bit per square. Squares are numbered
+// row-major in the same orientation the board is drawn: square 0 is row 0,
+// col 0 (a8) and square 63 is row 7, col 7 (h1).
+typedef uint64_t bitboard_t;
+
+#define SQUARE_COUNT 64
+
+#define ROW_0 0x00000000000000FFULL
+#define ROW_7 0xFF00000000000000ULL
+#define COL_A 0x0101010101010101ULL
+#define COL_H 0x8080808080808080ULL
+
+static inline int make_square(int row, int col) { return row * 8 + col; }
+static inline int square_row(int square) { return square >> 3; }
+static inline int square_col(int square) { return square & 7; }
+
+static inline bitboard_t square_bb(int square) {
+  return (bitboard_t)1 << square;
+}
+
+static inline int popcount(bitboard_t bb) { return __builtin_popcountll(bb); }
+
+// Index of the lowest / highest set bit; bb must not be empty
+static inline int lsb(bitboard_t bb) { return __builtin_ctzll(bb); }
+static inline int msb(bitboard_t bb) { return 63 - __builtin_clzll(bb); }
+
+// Remove and return the lowest set bit; bb must not be empty
+static inline int pop_lsb(bitboard_t *bb) {
+  int square = lsb(*bb);
+  *bb &= *bb - 1;
+  return square;
+}
+
+#endif // BITBOARD_H
@@ -0,0 +1,74 @@
+#include "board.h"
+#include <stddef.h>
+
+/// Validation functions
+int is_valid_position(int row, int col) {
+  return (row >= 0 && row < BOARD_SIZE && col >= 0 && col < BOARD_SIZE);
+}
+
+int is_valid_piece_type(int type) { return (type >= EMPTY && type <= KING); }
+
+int is_valid_color(int color) {
+  return (color == NONE || color == WHITE || color == BLACK);
+}
+
+int is_valid_theme(int theme) {
+  return (theme == THEME_DEFAULT || theme == THEME_WOOD);
+}
+
+/// Board manipulation functions
+void clear_board(board_t *board) {
+  if (!board)
+    return;
+
+  for (int sq = 0; sq < SQUARE_COUNT; sq++) {
+    board->squares[sq] = NO_PIECE;
+  }
+
+  for (int color = 0; color < COLOR_COUNT; color++) {
+    for (int type = 0; type < PIECE_TYPE_COUNT; type++) {
+      board->pieces[color][type] = 0;
+    }
+    board->occupied[color] = 0;
+  }
+
+  board->psq_mg = 0;
+  board->psq_eg = 0;
+  board->phase = 0;
+}
+
+piece_t get_piece_at(const board_t *board, int row, int col) {
+  if (!board || !is_valid_position(row, col)) {
+    return NO_PIECE;
+  }
+  return board->squares[make_square(row, col)];
+}
+
+int set_piece_at(board_t *board, int row, int col, piece_t piece) {
+  if (!board || !is_valid_position(row, col)) {
+    return ERROR_INVALID_INPUT;
+  }
+
+  if (!is_valid_piece_type(type_of(piece)) ||
+      !is_valid_color(color_of(piece))) {
+    return ERROR_INVALID_INPUT;
+  }
+
+  clear_piece_at(board, row, col);
+  if (type_of(piece) != EMPTY && color_of(piece) != NONE) {
+    put_piece(board, make_square(row, col), piece);
+  }
+  return ERROR_NONE;
+}
+
+int clear_piece_at(board_t *board, int row, int col) {
+  if (!board || !is_valid_position(row, col)) {
+    return ERROR_INVALID_INPUT;
+  }
+
+  if (board->squares[make_square(row, col)] != NO_PIECE) {
+    remove_piece(board, make_square(row, col));
+  }
+
+  return ERROR_NONE;
+}
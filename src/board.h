@@ -0,0 +1,108 @@
+#ifndef BOARD_H
+#define BOARD_H
+
+#include "bitboard.h"
+#include "config.h"
+
+// Piece types and colors
+enum {
+  EMPTY = 0,
+  PAWN = 1,
+  KNIGHT = 2,
+  ROOK = 3,
+  BISHOP = 4,
+  QUEEN = 5,
+  KING = 6
+};
+
+enum { NONE = 0, WHITE = 1, BLACK = 2 };
+
+enum { THEME_DEFAULT = 0, THEME_WOOD = 1 };
+
+#define PIECE_TYPE_COUNT 7
+#define COLOR_COUNT 3
+
+// A piece packed into one byte: type in bits 0-2, color in bits 3-4. The
+// sprite theme is a display setting and not part of the piece.
+typedef uint8_t piece_t;
+
+#define NO_PIECE ((piece_t)0)
+
+static inline piece_t make_piece(int type, int color) {
+  return (piece_t)(type | (color << 3));
+}
+static inline int type_of(piece_t piece) { return piece & 7; }
+static inline int color_of(piece_t piece) { return piece >> 3; }
+
+// Material plus piece-square value of each piece on each square, for the
+// middlegame and the endgame, from White's point of view (negative for
+// black pieces), and each piece type's weight in the game phase. Built by
+// init_psqt in psqt.c.
+extern int16_t psqt_mg[COLOR_COUNT][PIECE_TYPE_COUNT][SQUARE_COUNT];
+extern int16_t psqt_eg[COLOR_COUNT][PIECE_TYPE_COUNT][SQUARE_COUNT];
+extern const int psqt_phase[PIECE_TYPE_COUNT];
+
+// The squares array and the bitboards describe the same position and are
+// kept in sync by set_piece_at/clear_piece_at; never write either directly.
+// The same calls keep running totals of the piece-square tables, so the
+// evaluation never has to visit the pieces.
+typedef struct {
+  bitboard_t pieces[COLOR_COUNT][PIECE_TYPE_COUNT]; // [color][type]
+  bitboard_t occupied[COLOR_COUNT]; // [color], occupied[NONE] = all pieces
+  piece_t squares[SQUARE_COUNT];    // Indexed by square, NO_PIECE if empty
+  int psq_mg; // Sums of psqt_mg/psqt_eg over all pieces
+  int psq_eg;
+  int phase; // Sum of psqt_phase over all pieces
+} board_t;
+
+static inline int opponent_of(int color) {
+  return (color == WHITE) ? BLACK : WHITE;
+}
+
+// Unchecked primitives behind set_piece_at/clear_piece_at for hot paths such
+// as make/unmake. put_piece expects an empty square, remove_piece an occupied
+// one.
+static inline void put_piece(board_t *board, int square, piece_t piece) {
+  bitboard_t bb = square_bb(square);
+  int color = color_of(piece);
+  int type = type_of(piece);
+  board->squares[square] = piece;
+  board->pieces[color][type] |= bb;
+  board->occupied[color] |= bb;
+  board->occupied[NONE] |= bb;
+  board->psq_mg += psqt_mg[color][type][square];
+  board->psq_eg += psqt_eg[color][type][square];
+  board->phase += psqt_phase[type];
+}
+
+static inline piece_t remove_piece(board_t *board, int square) {
+  bitboard_t bb = square_bb(square);
+  piece_t piece = board->squares[square];
+  int color = color_of(piece);
+  int type = type_of(piece);
+  board->pieces[color][type] &= ~bb;
+  board->occupied[color] &= ~bb;
+  board->occupied[NONE] &= ~bb;
+  board->squares[square] = NO_PIECE;
+  board->psq_mg -= psqt_mg[color][type][square];
+  board->psq_eg -= psqt_eg[color][type][square];
+  board->phase -= psqt_phase[type];
+  return piece;
+}
+
+static inline piece_t piece_on(const board_t *board, int square) {
+  return board->squares[square];
+}
+
+int is_valid_position(int row, int col);
+int is_valid_piece_type(int type);
+int is_valid_color(int color);
+int is_valid_theme(int theme);
+
+// Board manipulation functions
+void clear_board(board_t *board);
+piece_t get_piece_at(const board_t* board, int row, int col);
+int set_piece_at(board_t* board, int row, int col, piece_t piece);
+int clear_piece_at(board_t* board, int row, int col);
+
+#endif // BOARD_H
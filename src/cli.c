@@ -0,0 +1,635 @@
+// Headless front end for the engine, built without SDL. Runs benchmarks and
+// other tools from the command line:
+//   chess-cli perft <depth> [--fen <FEN>] [--divide] [--hash <MB>]
+//                           [--threads <N>]
+//   chess-cli search [--fen <FEN>] [--depth <N>] [--nodes <N>]
+//                    [--movetime <ms>] [--wtime <ms>] [--btime <ms>]
+//                    [--winc <ms>] [--binc <ms>] [--movestogo <N>]
+//                    [--hash <MB>] [--threads <N>] [--nnue <file>]
+//                    [--params <file>] [--stats] [feature switches]
+//   chess-cli bench [depth] [--nnue <file>] [--params <file>] [--stats]
+//                   [feature switches]
+//   chess-cli tune <positions> [--threads <N>] [--epochs <N>] [--rate <R>]
+//                  [--k <K>] [--params <file>] [--out <file>]
+//   chess-cli batch [--fen <FEN>] [--file <path>] [--depth <N>]
+// The feature switches --no-pvs, --no-aspiration, --no-null, --no-lmr and
+// --no-futility turn off one search technique each. Without --nnue the
+// search evaluates with the piece-square tables, using the parameters from
+// --params if given. tune fits those parameters to labelled positions and
+// writes a file --params accepts; text positions are converted to
+// <positions>.bin first. batch checks the batched evaluation (batch.h)
+// against evaluate() and the attack tables on every position within --depth
+// plies of the bench positions, --fen or each line of --file.
+// clock_gettime is POSIX, hidden by -std=c11
+#define _POSIX_C_SOURCE 199309L
+#include "attacks.h"
+#include "batch.h"
+#include "eval.h"
+#include "movegen.h"
+#include "nnue.h"
+#include "params.h"
+#include "perft.h"
+#include "position.h"
+#include "search.h"
+#include "timer.h"
+#include "tune.h"
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define DEFAULT_HASH_MB 16
+#define DEFAULT_SEARCH_DEPTH 6
+#define DEFAULT_BENCH_DEPTH 6
+#define DEFAULT_TUNE_EPOCHS 500
+#define DEFAULT_TUNE_RATE 1.0
+#define DEFAULT_TUNE_OUTPUT "params.txt"
+#define DEFAULT_BATCH_DEPTH 2
+
+// Positions the batch check holds at once. Each chunk is evaluated in
+// batches, then one position at a time, and the two are compared.
+#define BATCH_CHUNK 65536
+
+// A command ran and its check failed; not a usage error
+#define CHECK_FAILED 2
+
+// Fixed positions for the search benchmark, mixing openings, middlegames
+// and endgames
+static const char *bench_fens[] = {
+    START_FEN,
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+    "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+    "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+    "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+    "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+    "r1bqkb1r/pppp1ppp/2n2n2/4p3/2B1P3/5N2/PPPP1PPP/RNBQK2R w KQkq - 4 4",
+    "8/8/1p1k4/p1p1p3/P1P1P3/1P1K4/8/8 w - - 0 1",
+};
+
+static void print_usage(const char *program) {
+  fprintf(stderr,
+          "Usage: %s perft <depth> [--fen <FEN>] [--divide] [--hash <MB>] "
+          "[--threads <N>]\n"
+          "       %s search [--fen <FEN>] [--depth <N>] [--nodes <N>] "
+          "[--movetime <ms>] [--wtime <ms>] [--btime <ms>] [--winc <ms>] "
+          "[--binc <ms>] [--movestogo <N>] [--hash <MB>] [--threads <N>] "
+          "[--nnue <file>] [--params <file>] [--stats] "
+          "[--no-pvs] [--no-aspiration] [--no-null] [--no-lmr] "
+          "[--no-futility]\n"
+          "       %s bench [depth] [--nnue <file>] [--params <file>] "
+          "[--stats] [--no-pvs] [--no-aspiration] "
+          "[--no-null] [--no-lmr] [--no-futility]\n"
+          "       %s tune <positions> [--threads <N>] [--epochs <N>] "
+          "[--rate <R>] [--k <K>] [--params <file>] [--out <file>]\n"
+          "       %s batch [--fen <FEN>] [--file <path>] [--depth <N>]\n",
+          program, program, program, program, program);
+}
+
+static position_t *new_position(const char *fen) {
+  position_t *pos = malloc(sizeof(position_t));
+  if (!pos) {
+    fprintf(stderr, "Out of memory\n");
+    return NULL;
+  }
+  if (position_set_fen(pos, fen) != ERROR_NONE) {
+    fprintf(stderr, "Invalid FEN: %s\n", fen);
+    free(pos);
+    return NULL;
+  }
+  return pos;
+}
+
+// Apply a --no-<technique> switch; returns 0 if arg is not one
+static int parse_feature_option(const char *arg, search_features_t *features) {
+  if (strcmp(arg, "--no-pvs") == 0) {
+    features->pvs = 0;
+  } else if (strcmp(arg, "--no-aspiration") == 0) {
+    features->aspiration = 0;
+  } else if (strcmp(arg, "--no-null") == 0) {
+    features->null_move = 0;
+  } else if (strcmp(arg, "--no-lmr") == 0) {
+    features->lmr = 0;
+  } else if (strcmp(arg, "--no-futility") == 0) {
+    features->futility = 0;
+  } else {
+    return 0;
+  }
+  return 1;
+}
+
+static void print_stats(const search_stats_t *stats) {
+  printf("PVS re-searches: %" PRIu64 "\n", stats->pvs_researches);
+  printf("Aspiration re-searches: %" PRIu64 "\n",
+         stats->aspiration_researches);
+  printf("Null move tries: %" PRIu64 "\n", stats->null_move_tries);
+  printf("Null move cutoffs: %" PRIu64 "\n", stats->null_move_cutoffs);
+  printf("Null move verifications: %" PRIu64 "\n",
+         stats->null_move_verifications);
+  printf("LMR reductions: %" PRIu64 "\n", stats->lmr_reductions);
+  printf("LMR re-searches: %" PRIu64 "\n", stats->lmr_researches);
+  printf("Futility prunes: %" PRIu64 "\n", stats->futility_prunes);
+  printf("Reverse futility prunes: %" PRIu64 "\n",
+         stats->reverse_futility_prunes);
+  printf("Pawn table hits: %" PRIu64 " of %" PRIu64 "\n",
+         stats->pawn_table_hits, stats->pawn_table_probes);
+}
+
+static void print_iteration(const search_info_t *info) {
+  printf("info depth %d score ", info->depth);
+  if (info->score >= SCORE_MATE_BOUND) {
+    printf("mate %d", (SCORE_MATE - info->score + 1) / 2);
+  } else if (info->score <= -SCORE_MATE_BOUND) {
+    printf("mate -%d", (SCORE_MATE + info->score) / 2);
+  } else {
+    printf("cp %d", info->score);
+  }
+  printf(" nodes %" PRIu64 " nps %" PRIu64 " hashfull %d time %" PRId64
+         " pv",
+         info->nodes, info->nps, info->hashfull, info->time_ms);
+  for (int i = 0; i < info->pv_length; i++) {
+    char uci[6];
+    move_to_uci(info->pv[i], uci);
+    printf(" %s", uci);
+  }
+  printf("\n");
+  fflush(stdout);
+}
+
+static int run_perft(int argc, char **argv) {
+  perft_options_t options = {0, 0, 0, 1};
+  const char *fen = START_FEN;
+
+  if (argc < 1) {
+    return 1;
+  }
+  options.depth = atoi(argv[0]);
+
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--divide") == 0) {
+      options.divide = 1;
+    } else if (strcmp(argv[i], "--fen") == 0 && i + 1 < argc) {
+      fen = argv[++i];
+    } else if (strcmp(argv[i], "--hash") == 0 && i + 1 < argc) {
+      options.hash_mb = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+      options.threads = atoi(argv[++i]);
+    } else {
+      fprintf(stderr, "Unknown perft option: %s\n", argv[i]);
+      return 1;
+    }
+  }
+
+  position_t *pos = new_position(fen);
+  if (!pos) {
+    return 1;
+  }
+
+  perft_run(pos, &options);
+  free(pos);
+  return 0;
+}
+
+static int run_search(int argc, char **argv) {
+  search_limits_t limits = {.on_iteration = print_iteration};
+  const char *fen = START_FEN;
+  int hash_mb = DEFAULT_HASH_MB;
+  const char *nnue_file = NULL;
+  const char *params_file = NULL;
+  int show_stats = 0;
+  search_features_t features;
+  search_get_features(&features);
+
+  for (int i = 0; i < argc; i++) {
+    if (strcmp(argv[i], "--fen") == 0 && i + 1 < argc) {
+      fen = argv[++i];
+    } else if (strcmp(argv[i], "--depth") == 0 && i + 1 < argc) {
+      limits.depth = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--nodes") == 0 && i + 1 < argc) {
+      limits.nodes = strtoull(argv[++i], NULL, 10);
+    } else if (strcmp(argv[i], "--movetime") == 0 && i + 1 < argc) {
+      limits.movetime = atoll(argv[++i]);
+    } else if (strcmp(argv[i], "--wtime") == 0 && i + 1 < argc) {
+      limits.time[WHITE] = atoll(argv[++i]);
+    } else if (strcmp(argv[i], "--btime") == 0 && i + 1 < argc) {
+      limits.time[BLACK] = atoll(argv[++i]);
+    } else if (strcmp(argv[i], "--winc") == 0 && i + 1 < argc) {
+      limits.increment[WHITE] = atoll(argv[++i]);
+    } else if (strcmp(argv[i], "--binc") == 0 && i + 1 < argc) {
+      limits.increment[BLACK] = atoll(argv[++i]);
+    } else if (strcmp(argv[i], "--movestogo") == 0 && i + 1 < argc) {
+      limits.moves_to_go = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--hash") == 0 && i + 1 < argc) {
+      hash_mb = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+      search_set_threads(atoi(argv[++i]));
+    } else if (strcmp(argv[i], "--nnue") == 0 && i + 1 < argc) {
+      nnue_file = argv[++i];
+    } else if (strcmp(argv[i], "--params") == 0 && i + 1 < argc) {
+      params_file = argv[++i];
+    } else if (strcmp(argv[i], "--stats") == 0) {
+      show_stats = 1;
+    } else if (parse_feature_option(argv[i], &features)) {
+      continue;
+    } else {
+      fprintf(stderr, "Unknown search option: %s\n", argv[i]);
+      return 1;
+    }
+  }
+
+  if (!limits.depth && !limits.nodes && !limits.movetime &&
+      !limits.time[WHITE] && !limits.time[BLACK]) {
+    limits.depth = DEFAULT_SEARCH_DEPTH;
+  }
+  search_set_features(&features);
+  if (nnue_file && nnue_load(nnue_file) != ERROR_NONE) {
+    return 1;
+  }
+  // Before the position is set up, which totals the piece-square tables
+  if (params_file && params_load(params_file) != ERROR_NONE) {
+    return 1;
+  }
+
+  position_t *pos = new_position(fen);
+  if (!pos) {
+    return 1;
+  }
+  if (search_init((size_t)hash_mb) != ERROR_NONE) {
+    fprintf(stderr, "Could not allocate %d MB hash\n", hash_mb);
+    free(pos);
+    return 1;
+  }
+
+  search_info_t info;
+  char uci[6] = "0000";
+  move_t best = search_run(pos, &limits, &info);
+  if (best != MOVE_NONE) {
+    move_to_uci(best, uci);
+  }
+  if (show_stats) {
+    print_stats(&info.stats);
+  }
+  printf("bestmove %s\n", uci);
+
+  search_cleanup();
+  free(pos);
+  return 0;
+}
+
+// Search every bench position to a fixed depth from a clear table. The node
+// total is deterministic, so it doubles as a check that a change did not
+// alter the search.
+static int run_bench(int argc, char **argv) {
+  search_limits_t limits = {.depth = DEFAULT_BENCH_DEPTH};
+  const char *nnue_file = NULL;
+  const char *params_file = NULL;
+  int show_stats = 0;
+  search_features_t features;
+  search_get_features(&features);
+
+  for (int i = 0; i < argc; i++) {
+    if (strcmp(argv[i], "--stats") == 0) {
+      show_stats = 1;
+    } else if (strcmp(argv[i], "--nnue") == 0 && i + 1 < argc) {
+      nnue_file = argv[++i];
+    } else if (strcmp(argv[i], "--params") == 0 && i + 1 < argc) {
+      params_file = argv[++i];
+    } else if (parse_feature_option(argv[i], &features)) {
+      continue;
+    } else if (i == 0) {
+      limits.depth = atoi(argv[0]);
+    } else {
+      fprintf(stderr, "Unknown bench option: %s\n", argv[i]);
+      return 1;
+    }
+  }
+  search_set_features(&features);
+  if (nnue_file && nnue_load(nnue_file) != ERROR_NONE) {
+    return 1;
+  }
+  if (params_file && params_load(params_file) != ERROR_NONE) {
+    return 1;
+  }
+
+  if (search_init(DEFAULT_HASH_MB) != ERROR_NONE) {
+    fprintf(stderr, "Could not allocate hash\n");
+    return 1;
+  }
+
+  uint64_t total_nodes = 0;
+  int64_t total_time = 0;
+  search_stats_t total_stats;
+  memset(&total_stats, 0, sizeof(total_stats));
+  int count = (int)(sizeof(bench_fens) / sizeof(bench_fens[0]));
+
+  for (int i = 0; i < count; i++) {
+    position_t *pos = new_position(bench_fens[i]);
+    if (!pos) {
+      search_cleanup();
+      return 1;
+    }
+
+    search_info_t info;
+    char uci[6] = "0000";
+    search_new_game();
+    move_t best = search_run(pos, &limits, &info);
+    if (best != MOVE_NONE) {
+      move_to_uci(best, uci);
+    }
+
+    printf("Position %d: bestmove %s score %d nodes %" PRIu64 "\n", i + 1,
+           uci, info.score, info.nodes);
+    total_nodes += info.nodes;
+    total_time += info.time_ms;
+    search_stats_add(&total_stats, &info.stats);
+    free(pos);
+  }
+
+  printf("\nNodes: %" PRIu64 "\n", total_nodes);
+  printf("Time: %" PRId64 " ms\n", total_time);
+  printf("NPS: %" PRIu64 "\n",
+         total_nodes * 1000 / (uint64_t)(total_time > 0 ? total_time : 1));
+  if (show_stats) {
+    printf("\n");
+    print_stats(&total_stats);
+  }
+
+  search_cleanup();
+  return 0;
+}
+
+// Fit the evaluation parameters to labelled positions. Starts from the
+// built-in values, or from --params.
+static int run_tune(int argc, char **argv) {
+  if (argc < 1) {
+    return -1;
+  }
+  tune_options_t options = {
+      .epochs = DEFAULT_TUNE_EPOCHS,
+      .rate = DEFAULT_TUNE_RATE,
+      .output = DEFAULT_TUNE_OUTPUT,
+  };
+  const char *params_file = NULL;
+
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+      options.threads = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--epochs") == 0 && i + 1 < argc) {
+      options.epochs = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--rate") == 0 && i + 1 < argc) {
+      options.rate = atof(argv[++i]);
+    } else if (strcmp(argv[i], "--k") == 0 && i + 1 < argc) {
+      options.k = atof(argv[++i]);
+    } else if (strcmp(argv[i], "--params") == 0 && i + 1 < argc) {
+      params_file = argv[++i];
+    } else if (strcmp(argv[i], "--out") == 0 && i + 1 < argc) {
+      options.output = argv[++i];
+    } else {
+      fprintf(stderr, "Unknown tune option: %s\n", argv[i]);
+      return 1;
+    }
+  }
+  if (params_file && params_load(params_file) != ERROR_NONE) {
+    return 1;
+  }
+
+  // Text positions are converted once; later runs can be given the .bin
+  char binary[1024];
+  const char *data = argv[0];
+  if (!tune_is_binary(data)) {
+    snprintf(binary, sizeof(binary), "%s.bin", data);
+    if (tune_convert(data, binary) != ERROR_NONE) {
+      return 1;
+    }
+    data = binary;
+  }
+  return (tune_run(data, &options) == ERROR_NONE) ? 0 : 1;
+}
+
+typedef struct {
+  board_t *boards;
+  int *sides;
+  batch_result_t *results; // One per group of BATCH_SIZE boards
+  int count;               // Boards in the current chunk
+  position_t *scratch;     // What evaluate() is given
+  uint64_t positions;
+  uint64_t mismatches;
+  int64_t batch_ms;
+  int64_t single_ms;
+} batch_check_t;
+
+// Attack map and mobility of color the plain way, one piece at a time from
+// the lookup tables
+static void reference_attacks(const board_t *board, int color,
+                              bitboard_t *attacks, int *mobility) {
+  bitboard_t occupied = board->occupied[NONE];
+  *attacks = 0;
+  *mobility = 0;
+  for (int type = PAWN; type <= KING; type++) {
+    bitboard_t pieces = board->pieces[color][type];
+    while (pieces) {
+      int square = pop_lsb(&pieces);
+      bitboard_t bb = 0;
+      switch (type) {
+      case PAWN:
+        bb = pawn_attacks[color][square];
+        break;
+      case KNIGHT:
+        bb = knight_attacks[square];
+        break;
+      case BISHOP:
+        bb = bishop_attacks(square, occupied);
+        break;
+      case ROOK:
+        bb = rook_attacks(square, occupied);
+        break;
+      case QUEEN:
+        bb = queen_attacks(square, occupied);
+        break;
+      default:
+        bb = king_attacks[square];
+        break;
+      }
+      *attacks |= bb;
+      if (type != PAWN && type != KING)
+        *mobility += popcount(bb & ~board->occupied[color]);
+    }
+  }
+}
+
+// Evaluate the chunk in batches, then one position at a time, timing each
+// pass, and count the positions where any result differs
+static void check_chunk(batch_check_t *check) {
+  position_t *pos = check->scratch;
+  batch_t batch;
+
+  int64_t start = time_now_ms();
+  for (int first = 0; first < check->count; first += BATCH_SIZE) {
+    batch_clear(&batch);
+    for (int i = first; i < first + BATCH_SIZE && i < check->count; i++) {
+      pos->board = check->boards[i];
+      pos->side_to_move = check->sides[i];
+      batch_add(&batch, pos);
+    }
+    batch_evaluate(&batch, &check->results[first / BATCH_SIZE]);
+  }
+  int64_t middle = time_now_ms();
+
+  for (int i = 0; i < check->count; i++) {
+    pos->board = check->boards[i];
+    pos->side_to_move = check->sides[i];
+    const batch_result_t *result = &check->results[i / BATCH_SIZE];
+    int lane = i % BATCH_SIZE;
+    int same = evaluate(pos) == result->eval[lane];
+    for (int color = WHITE; color <= BLACK; color++) {
+      bitboard_t attacks;
+      int mobility;
+      reference_attacks(&pos->board, color, &attacks, &mobility);
+      same = same && attacks == result->attacks[color][lane] &&
+             mobility == result->mobility[color][lane];
+    }
+    if (!same && check->mismatches++ < 10) {
+      fprintf(stderr, "Mismatch at position %" PRIu64 "\n",
+              check->positions + (uint64_t)i + 1);
+    }
+  }
+  check->single_ms += time_now_ms() - middle;
+  check->batch_ms += middle - start;
+  check->positions += (uint64_t)check->count;
+  check->count = 0;
+}
+
+// Every position within depth plies of pos, pos included
+static void collect_positions(position_t *pos, int depth,
+                              batch_check_t *check) {
+  check->boards[check->count] = pos->board;
+  check->sides[check->count] = pos->side_to_move;
+  if (++check->count == BATCH_CHUNK)
+    check_chunk(check);
+  if (depth <= 0)
+    return;
+
+  move_list_t list;
+  generate_legal_moves(pos, &list);
+  for (int i = 0; i < list.count; i++) {
+    make_move(pos, list.moves[i]);
+    collect_positions(pos, depth - 1, check);
+    unmake_move(pos);
+  }
+}
+
+static int collect_from_fen(const char *fen, int depth, batch_check_t *check) {
+  position_t *pos = new_position(fen);
+  if (!pos) {
+    return 0;
+  }
+  collect_positions(pos, depth, check);
+  free(pos);
+  return 1;
+}
+
+// Check the batched evaluation against evaluate() and the attack tables
+static int run_batch(int argc, char **argv) {
+  const char *fen = NULL;
+  const char *file = NULL;
+  int depth = DEFAULT_BATCH_DEPTH;
+
+  for (int i = 0; i < argc; i++) {
+    if (strcmp(argv[i], "--fen") == 0 && i + 1 < argc) {
+      fen = argv[++i];
+    } else if (strcmp(argv[i], "--file") == 0 && i + 1 < argc) {
+      file = argv[++i];
+    } else if (strcmp(argv[i], "--depth") == 0 && i + 1 < argc) {
+      depth = atoi(argv[++i]);
+    } else {
+      fprintf(stderr, "Unknown batch option: %s\n", argv[i]);
+      return 1;
+    }
+  }
+
+  FILE *in = NULL;
+  if (file && !(in = fopen(file, "r"))) {
+    fprintf(stderr, "Unable to open %s\n", file);
+    return 1;
+  }
+  batch_check_t check = {0};
+  check.boards = malloc(sizeof(board_t) * BATCH_CHUNK);
+  check.sides = malloc(sizeof(int) * BATCH_CHUNK);
+  check.results = malloc(sizeof(batch_result_t) * (BATCH_CHUNK / BATCH_SIZE));
+  check.scratch = malloc(sizeof(position_t));
+  if (!check.boards || !check.sides || !check.results || !check.scratch) {
+    fprintf(stderr, "Out of memory\n");
+    free(check.boards);
+    free(check.sides);
+    free(check.results);
+    free(check.scratch);
+    if (in)
+      fclose(in);
+    return 1;
+  }
+  position_clear(check.scratch);
+
+  int skipped = 0;
+  if (in) {
+    // FEN or EPD, one position per line
+    char line[512];
+    while (fgets(line, sizeof(line), in)) {
+      line[strcspn(line, "\r\n")] = '\0';
+      if (line[0] != '\0' && !collect_from_fen(line, depth, &check))
+        skipped++;
+    }
+    fclose(in);
+  } else if (fen) {
+    skipped += !collect_from_fen(fen, depth, &check);
+  } else {
+    int count = (int)(sizeof(bench_fens) / sizeof(bench_fens[0]));
+    for (int i = 0; i < count; i++)
+      collect_from_fen(bench_fens[i], depth, &check);
+  }
+  if (check.count > 0)
+    check_chunk(&check);
+
+  printf("Positions: %" PRIu64 "\n", check.positions);
+  if (skipped)
+    printf("Skipped: %d invalid lines\n", skipped);
+  printf("Mismatches: %" PRIu64 "\n", check.mismatches);
+  // Under a millisecond counts as one, so the rates stay rates
+  printf("Batch: %" PRIu64 " positions/s\n",
+         check.positions * 1000 /
+             (uint64_t)(check.batch_ms > 0 ? check.batch_ms : 1));
+  printf("Single: %" PRIu64 " positions/s\n",
+         check.positions * 1000 /
+             (uint64_t)(check.single_ms > 0 ? check.single_ms : 1));
+
+  free(check.boards);
+  free(check.sides);
+  free(check.results);
+  free(check.scratch);
+  if (check.mismatches || (fen && skipped))
+    return CHECK_FAILED;
+  return 0;
+}
+
+int main(int argc, char **argv) {
+  int result = -1;
+
+  if (argc >= 2 && strcmp(argv[1], "perft") == 0) {
+    result = run_perft(argc - 2, argv + 2);
+  } else if (argc >= 2 && strcmp(argv[1], "search") == 0) {
+    result = run_search(argc - 2, argv + 2);
+  } else if (argc >= 2 && strcmp(argv[1], "bench") == 0) {
+    result = run_bench(argc - 2, argv + 2);
+  } else if (argc >= 2 && strcmp(argv[1], "tune") == 0) {
+    result = run_tune(argc - 2, argv + 2);
+  } else if (argc >= 2 && strcmp(argv[1], "batch") == 0) {
+    result = run_batch(argc - 2, argv + 2);
+  }
+
+  if (result == CHECK_FAILED) {
+    return 1;
+  }
+  if (result != 0) {
+    print_usage(argv[0]);
+    return 1;
+  }
+  return 0;
+}
@@ -24,6 +24,20 @@
 #define PAUSED_FPS 30
 #define FPS_UPDATE_INTERVAL 1000
 
+// Game clock: time per side and increment per move, in milliseconds. A
+// clock of 0 plays without one.
+#define GAME_CLOCK 300000
+#define GAME_INCREMENT 3000
+
+// Engine opponent
+#define ENGINE_HASH_MB 64
+#define ENGINE_MOVETIME 2000 // Milliseconds per engine move without a clock
+#define ENGINE_PONDER 1       // Think on the opponent's time by default
+// Network to evaluate with; the piece-square tables are used without it
+#define ENGINE_NNUE_FILE "assets/engine.nnue"
+// Tuned evaluation parameters (see chess-cli tune), loaded when present
+#define ENGINE_PARAMS_FILE "assets/engine.params"
+
 // Colors (RGB values)
 #define COLOR_BLACK 0, 0, 0
 #define COLOR_WHITE 255, 255, 255
@@ -0,0 +1,23 @@
+#include "eval.h"
+#include "nnue.h"
+#include "pawns.h"
+#include "psqt.h"
+
+int evaluate(const position_t *pos) {
+  if (pos->nnue && nnue_is_loaded() && pos->nnue->top < NNUE_STACK_SIZE) {
+    return nnue_evaluate(pos);
+  }
+
+  const board_t *board = &pos->board;
+  int pawns_mg, pawns_eg;
+  pawns_evaluate(pos, &pawns_mg, &pawns_eg);
+  int mg = board->psq_mg + pawns_mg;
+  int eg = board->psq_eg + pawns_eg;
+
+  // Blend the middlegame and endgame totals by how much material is left;
+  // promotions can push the phase past the maximum
+  int phase = board->phase < PHASE_MAX ? board->phase : PHASE_MAX;
+  int score = (mg * phase + eg * (PHASE_MAX - phase)) / PHASE_MAX;
+
+  return (pos->side_to_move == WHITE) ? score : -score;
+}
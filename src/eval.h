@@ -0,0 +1,14 @@
+#ifndef EVAL_H
+#define EVAL_H
+
+#include "position.h"
+
+// Static evaluation in centipawns from the side to move's point of view.
+// With a network loaded and accumulators attached to pos this is the NNUE;
+// otherwise material, piece-square tables and pawn structure, tapered
+// between middlegame and endgame by the game phase. The board keeps the
+// piece-square sums up to date as pieces move and the pawn terms come from
+// a per-thread cache, so that is mostly a few arithmetic operations.
+int evaluate(const position_t *pos);
+
+#endif // EVAL_H
@@ -1,9 +1,12 @@
 #include "game.h"
+#include "movegen.h"
 #include "piece.h"
 #include "renderer.h"
+#include "worker.h"
 #include <SDL2/SDL_ttf.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 static game_state_t g_game_state = {0};
 
@@ -27,18 +30,21 @@ char get_piece_symbol(int piece_type) {
 }
 
 // Convert move to chess notation
-void move_to_notation(move_history_t *move, char *notation, int max_len) {
-  if (!move || !notation)
+void move_to_notation(move_history_t *entry, char *notation, int max_len) {
+  if (!entry || !notation)
     return;
 
-  char piece_symbol = get_piece_symbol(move->moved_piece.type);
-  char from_file = col_to_file(move->from_col);
-  char to_file = col_to_file(move->to_col);
-  int to_rank = row_to_rank(move->to_row);
+  move_t move = entry->move;
+  int from = move_from(move);
+  int to = move_to(move);
+  char piece_symbol = get_piece_symbol(entry->moved_piece);
+  char from_file = col_to_file(square_col(from));
+  char to_file = col_to_file(square_col(to));
+  int to_rank = row_to_rank(square_row(to));
 
   // Handle special moves first
-  if (move->is_castling) {
-    if (move->to_col > move->from_col) {
+  if (move_flags(move) == MOVE_CASTLING) {
+    if (to > from) {
       snprintf(notation, max_len, "O-O"); // Kingside castling
     } else {
       snprintf(notation, max_len, "O-O-O"); // Queenside castling
@@ -46,9 +52,9 @@ void move_to_notation(move_history_t *move, char *notation, int max_len) {
     return;
   }
 
-  if (move->is_promotion) {
-    char promotion_symbol = get_piece_symbol(move->promotion_piece);
-    if (move->captured_piece.type != EMPTY) {
+  if (move_flags(move) == MOVE_PROMOTION) {
+    char promotion_symbol = get_piece_symbol(move_promotion(move));
+    if (entry->captured_piece != EMPTY) {
       // Pawn capture with promotion (e.g., exd8=Q)
       snprintf(notation, max_len, "%cx%d=%c", from_file, to_rank,
                promotion_symbol);
@@ -60,16 +66,16 @@ void move_to_notation(move_history_t *move, char *notation, int max_len) {
     return;
   }
 
-  if (move->is_en_passant) {
+  if (move_flags(move) == MOVE_EN_PASSANT) {
     // En passant capture (e.g., exd6 e.p.)
     snprintf(notation, max_len, "%cx%d e.p.", from_file, to_rank);
     return;
   }
 
   // Regular moves
-  if (move->captured_piece.type != EMPTY) {
+  if (entry->captured_piece != EMPTY) {
     // Capture move
-    if (move->moved_piece.type == PAWN) {
+    if (entry->moved_piece == PAWN) {
       // Pawn capture (e.g., exd5)
       snprintf(notation, max_len, "%cx%d", from_file, to_rank);
     } else {
@@ -78,7 +84,7 @@ void move_to_notation(move_history_t *move, char *notation, int max_len) {
     }
   } else {
     // Normal move
-    if (move->moved_piece.type == PAWN) {
+    if (entry->moved_piece == PAWN) {
       // Pawn move (e.g., e4)
       snprintf(notation, max_len, "%c%d", to_file, to_rank);
     } else {
@@ -89,69 +95,29 @@ void move_to_notation(move_history_t *move, char *notation, int max_len) {
 }
 
 void init_standard_board(void) {
-  int initial_positions[8][8] = {
-      {ROOK, KNIGHT, BISHOP, QUEEN, KING, BISHOP, KNIGHT, ROOK},
-      {PAWN, PAWN, PAWN, PAWN, PAWN, PAWN, PAWN, PAWN},
-      {EMPTY, EMPTY, EMPTY, EMPTY, EMPTY, EMPTY, EMPTY, EMPTY},
-      {EMPTY, EMPTY, EMPTY, EMPTY, EMPTY, EMPTY, EMPTY, EMPTY},
-      {EMPTY, EMPTY, EMPTY, EMPTY, EMPTY, EMPTY, EMPTY, EMPTY},
-      {EMPTY, EMPTY, EMPTY, EMPTY, EMPTY, EMPTY, EMPTY, EMPTY},
-      {PAWN, PAWN, PAWN, PAWN, PAWN, PAWN, PAWN, PAWN},
-      {ROOK, KNIGHT, BISHOP, QUEEN, KING, BISHOP, KNIGHT, ROOK}};
-
-  for (int col = 0; col < BOARD_SIZE; col++) {
-    /// WHITE
-    g_game_state.board.squares[7][col].piece.type = initial_positions[0][col];
-    g_game_state.board.squares[7][col].piece.color = WHITE;
-
-    // Pawns
-    g_game_state.board.squares[6][col].piece.type = initial_positions[1][col];
-    g_game_state.board.squares[6][col].piece.color = WHITE;
-
-    /// BLACK
-    g_game_state.board.squares[0][col].piece.type = initial_positions[7][col];
-    g_game_state.board.squares[0][col].piece.color = BLACK;
-
-    // Pawns
-    g_game_state.board.squares[1][col].piece.type = initial_positions[6][col];
-    g_game_state.board.squares[1][col].piece.color = BLACK;
-  }
+  position_set_start(&g_game_state.position);
 }
 
 game_state_t *init_game_state(void) {
-  // Initialize board with empty pieces
-  for (int row = 0; row < BOARD_SIZE; row++) {
-    for (int col = 0; col < BOARD_SIZE; col++) {
-      g_game_state.board.squares[row][col].piece.type = EMPTY;
-      g_game_state.board.squares[row][col].piece.color = NONE;
-      g_game_state.board.squares[row][col].piece.theme = THEME_DEFAULT;
-      g_game_state.board.squares[row][col].row = row;
-      g_game_state.board.squares[row][col].column = col;
-    }
-  }
-
-  g_game_state.current_turn = WHITE;
-  g_game_state.selected_piece_row = -1;
-  g_game_state.selected_piece_col = -1;
-  g_game_state.game_over = 0;     // Game ongoing
-  g_game_state.move_count = -1;   // Indicates game just started
-  g_game_state.render_needed = 1; // Initial render needed
+  g_game_state.ui.selected_row = -1;
+  g_game_state.ui.selected_col = -1;
+  g_game_state.ui.possible_moves = 0;
+  g_game_state.ui.theme = THEME_DEFAULT;
+  g_game_state.ui.render_needed = 1; // Initial render needed
+  g_game_state.game_over = 0;        // Game ongoing
+  g_game_state.clock[WHITE] = GAME_CLOCK;
+  g_game_state.clock[BLACK] = GAME_CLOCK;
+  g_game_state.turn_start = SDL_GetTicks();
+  g_game_state.move_count = -1;      // Indicates game just started
+  g_game_state.engine_color = NONE;
+  g_game_state.engine_search = 0;
+  g_game_state.ponder = ENGINE_PONDER;
+  g_game_state.engine_pondering = 0;
+  g_game_state.ponder_move = MOVE_NONE;
   g_game_state.input_state = malloc(sizeof(input_state_t));
 
-  // Initialize castling rights
-  g_game_state.white_can_castle_kingside = 1;
-  g_game_state.white_can_castle_queenside = 1;
-  g_game_state.black_can_castle_kingside = 1;
-  g_game_state.black_can_castle_queenside = 1;
-
-  // Clear possible moves
-  for (int row = 0; row < BOARD_SIZE; row++) {
-    for (int col = 0; col < BOARD_SIZE; col++) {
-      g_game_state.possible_moves[row][col] = 0;
-    }
-  }
-
-  // Assign standard chess starting positions
+  // Assign standard chess starting positions (also clears castling and en
+  // passant state)
   init_standard_board();
 
   return &g_game_state;
@@ -179,175 +145,223 @@ void find_square_by_coordinates(SDL_Renderer *renderer, int x, int y, int *row,
 
 void find_piece_by_square(int row, int col) {
   if (is_valid_position(row, col)) {
-    piece_t *piece = get_piece_at(&g_game_state.board, row, col);
-    if (piece && piece->type != EMPTY) {
-      g_game_state.selected_piece_row = row;
-      g_game_state.selected_piece_col = col;
+    piece_t piece = get_piece_at(&g_game_state.position.board, row, col);
+    if (piece != NO_PIECE) {
+      g_game_state.ui.selected_row = row;
+      g_game_state.ui.selected_col = col;
       return;
     }
 
-    g_game_state.selected_piece_row = -1;
-    g_game_state.selected_piece_col = -1;
+    g_game_state.ui.selected_row = -1;
+    g_game_state.ui.selected_col = -1;
     printf("No piece at (%d, %d)\n", row, col);
   }
 
-  g_game_state.selected_piece_row = -1;
-  g_game_state.selected_piece_col = -1;
+  g_game_state.ui.selected_row = -1;
+  g_game_state.ui.selected_col = -1;
 }
 
-void clear_possible_moves(void) {
-  for (int row = 0; row < BOARD_SIZE; row++) {
-    for (int col = 0; col < BOARD_SIZE; col++) {
-      g_game_state.possible_moves[row][col] = 0;
-    }
-  }
+void clear_possible_moves(void) { g_game_state.ui.possible_moves = 0; }
+
+// Time left for color right now; only the side to move's clock is running
+int64_t clock_remaining(int color) {
+  int64_t remaining = g_game_state.clock[color];
+  if (color == g_game_state.position.side_to_move)
+    remaining -= (int64_t)(SDL_GetTicks() - g_game_state.turn_start);
+  return remaining > 0 ? remaining : 0;
 }
 
-int try_make_move(int row, int col) {
-  piece_t *selected_piece =
-      get_piece_at(&g_game_state.board, g_game_state.selected_piece_row,
-                   g_game_state.selected_piece_col);
-  if (!selected_piece) {
-    return 0; // No piece selected
-  }
+// Stop the clock of the side that just moved and start the other one
+void switch_clock(void) {
+  int side = g_game_state.position.side_to_move;
+  if (GAME_CLOCK > 0)
+    g_game_state.clock[side] = clock_remaining(side) + GAME_INCREMENT;
+  g_game_state.turn_start = SDL_GetTicks();
+}
+
+// Record a legal move in the history and play it
+void play_move(move_t move) {
+  position_t *position = &g_game_state.position;
+  int to = move_to(move);
 
-  // Get the piece that will be captured (if any)
-  piece_t *captured_piece = get_piece_at(&g_game_state.board, row, col);
-  piece_t captured_piece_copy = {0};
-  if (captured_piece && captured_piece->type != EMPTY) {
-    captured_piece_copy = *captured_piece;
+  if (move_flags(move) == MOVE_CASTLING) {
+    printf("Castling move detected.\n");
+  } else if (move_flags(move) == MOVE_PROMOTION) {
+    printf("Pawn promotion to Queen.\n");
+  } else if (move_flags(move) == MOVE_EN_PASSANT) {
+    printf("En passant capture detected.\n");
   }
 
   // Record move in history BEFORE making the move
-  g_game_state.move_list[g_game_state.move_count].from_row =
-      g_game_state.selected_piece_row;
-  g_game_state.move_list[g_game_state.move_count].from_col =
-      g_game_state.selected_piece_col;
-  g_game_state.move_list[g_game_state.move_count].to_row = row;
-  g_game_state.move_list[g_game_state.move_count].to_col = col;
-  g_game_state.move_list[g_game_state.move_count].moved_piece = *selected_piece;
-  g_game_state.move_list[g_game_state.move_count].captured_piece =
-      captured_piece_copy;
-
-  // Initialize special move flags
-  g_game_state.move_list[g_game_state.move_count].is_castling = 0;
-  g_game_state.move_list[g_game_state.move_count].is_en_passant = 0;
-  g_game_state.move_list[g_game_state.move_count].is_promotion = 0;
-  g_game_state.move_list[g_game_state.move_count].promotion_piece = EMPTY;
-
-  // Initialize castling fields
-  g_game_state.move_list[g_game_state.move_count].rook_from_row = -1;
-  g_game_state.move_list[g_game_state.move_count].rook_from_col = -1;
-  g_game_state.move_list[g_game_state.move_count].rook_to_row = -1;
-  g_game_state.move_list[g_game_state.move_count].rook_to_col = -1;
-  g_game_state.move_list[g_game_state.move_count].rook_piece.type = EMPTY;
-  g_game_state.move_list[g_game_state.move_count].rook_piece.color = NONE;
-  g_game_state.move_list[g_game_state.move_count].rook_piece.theme =
-      THEME_DEFAULT;
-
-  // Detect special moves
-  if (selected_piece->type == KING &&
-      abs(row - g_game_state.selected_piece_row) == 0 &&
-      abs(col - g_game_state.selected_piece_col) == 2) {
-    // Castling move detected
-    g_game_state.move_list[g_game_state.move_count].is_castling = 1;
-
-    // Store rook information in the same move entry for easier undo
-    int rook_from_col =
-        (col > g_game_state.selected_piece_col) ? 7 : 0; // h or a
-    int rook_to_col =
-        (col > g_game_state.selected_piece_col) ? col - 1 : col + 1; // f or d
-    int rook_row = g_game_state.selected_piece_row;
-    piece_t *rook_piece =
-        get_piece_at(&g_game_state.board, rook_row, rook_from_col);
-
-    if (rook_piece && rook_piece->type == ROOK &&
-        rook_piece->color == selected_piece->color) {
-      g_game_state.move_list[g_game_state.move_count].rook_from_row = rook_row;
-      g_game_state.move_list[g_game_state.move_count].rook_from_col =
-          rook_from_col;
-      g_game_state.move_list[g_game_state.move_count].rook_to_row = rook_row;
-      g_game_state.move_list[g_game_state.move_count].rook_to_col = rook_to_col;
-      g_game_state.move_list[g_game_state.move_count].rook_piece = *rook_piece;
-
-      // Move the rook
-      set_piece_at(&g_game_state.board, rook_row, rook_to_col, *rook_piece);
-      clear_piece_at(&g_game_state.board, rook_row, rook_from_col);
-    }
+  move_history_t *entry = &g_game_state.history[g_game_state.move_count];
+  entry->move = move;
+  entry->moved_piece =
+      (uint8_t)type_of(piece_on(&position->board, move_from(move)));
+  entry->captured_piece =
+      (move_flags(move) == MOVE_EN_PASSANT)
+          ? PAWN
+          : (uint8_t)type_of(piece_on(&position->board, to));
+
+  switch_clock();
+  make_move(position, move);
+  g_game_state.move_count++;
+  printf("It's now %s's turn.\n",
+         (position->side_to_move == WHITE) ? "White" : "Black");
 
-    printf("Castling move detected.\n");
+  // Clear selection and possible moves
+  g_game_state.ui.selected_row = -1;
+  g_game_state.ui.selected_col = -1;
+  clear_possible_moves();
+}
+
+// Limits for an engine search: the clocks if the game has them, a fixed
+// time per move otherwise. A ponder search runs while the opponent's clock
+// ticks, so the engine's clock is as it will be once they have moved.
+void engine_limits(search_limits_t *limits, int ponder) {
+  memset(limits, 0, sizeof(*limits));
+  limits->ponder = ponder;
+  if (GAME_CLOCK <= 0) {
+    limits->movetime = ENGINE_MOVETIME;
+    return;
   }
+  limits->time[WHITE] = clock_remaining(WHITE);
+  limits->time[BLACK] = clock_remaining(BLACK);
+  limits->increment[WHITE] = GAME_INCREMENT;
+  limits->increment[BLACK] = GAME_INCREMENT;
+}
 
-  if (selected_piece->type == PAWN &&
-      ((selected_piece->color == WHITE && row == 0) ||
-       (selected_piece->color == BLACK && row == 7))) {
-    // Pawn promotion detected
-    g_game_state.move_list[g_game_state.move_count].is_promotion = 1;
-    g_game_state.move_list[g_game_state.move_count].promotion_piece =
-        QUEEN; // Default to queen
-    printf("Pawn promotion to Queen.\n");
+// Hand the position to the engine worker; the move arrives through
+// poll_engine a few frames later
+void start_engine_move(void) {
+  if (g_game_state.position.ply >= POSITION_MAX_PLY - 1) {
+    printf("Move limit reached, no more moves can be recorded.\n");
+    return;
   }
 
-  if (selected_piece->type == PAWN && captured_piece_copy.type == EMPTY &&
-      col != g_game_state.selected_piece_col) {
-    // En passant capture detected
-    g_game_state.move_list[g_game_state.move_count].is_en_passant = 1;
-    printf("En passant capture detected.\n");
+  search_limits_t limits;
+  engine_limits(&limits, 0);
+  g_game_state.engine_search = worker_search(&g_game_state.position, &limits);
+  if (g_game_state.engine_search != 0) {
+    printf("Engine is thinking for %s...\n",
+           (g_game_state.position.side_to_move == WHITE) ? "White"
+                                                          : "Black");
+  }
+}
+
+void cancel_engine_move(void) {
+  if (g_game_state.engine_search == 0)
+    return;
+  worker_stop();
+  g_game_state.engine_search = 0; // Its result will be ignored
+  g_game_state.engine_pondering = 0;
+}
 
-    // Clear the captured pawn
-    int captured_row = (selected_piece->color == WHITE) ? row + 1 : row - 1;
-    captured_piece_copy = *captured_piece;
+// After the engine moved, search the position after the reply its principal
+// variation expects while the opponent thinks
+void start_ponder(const worker_result_t *result) {
+  if (!g_game_state.ponder || g_game_state.engine_color == NONE ||
+      result->info.pv_length < 2)
+    return;
+
+  move_t expected = result->info.pv[1];
+  position_t position = g_game_state.position;
+  if (position.ply >= POSITION_MAX_PLY - 2 ||
+      !move_is_legal(&position, expected))
+    return;
+  make_move(&position, expected);
+
+  search_limits_t limits;
+  engine_limits(&limits, 1);
+  uint32_t id = worker_search(&position, &limits);
+  if (id == 0)
+    return;
+
+  char uci[6];
+  move_to_uci(expected, uci);
+  printf("Engine expects %s and thinks ahead.\n", uci);
+  g_game_state.engine_search = id;
+  g_game_state.engine_pondering = 1;
+  g_game_state.ponder_move = expected;
+}
+
+// The opponent played move. If the engine guessed it, its ponder search
+// simply carries on; otherwise it starts over, with the transposition table
+// still holding what pondering found.
+void engine_reply(move_t move) {
+  if (g_game_state.engine_color != g_game_state.position.side_to_move)
+    return;
 
-    g_game_state.move_list[g_game_state.move_count].captured_piece =
-        *get_piece_at(&g_game_state.board, captured_row, col);
-    clear_piece_at(&g_game_state.board, captured_row, col);
+  if (g_game_state.engine_pondering && move == g_game_state.ponder_move) {
+    worker_ponderhit(g_game_state.engine_search);
+    g_game_state.engine_pondering = 0;
+    printf("Engine expected this move and keeps thinking.\n");
+    return;
   }
 
-  // Update castling rights before moving pieces
-  if (selected_piece->type == KING) {
-    if (selected_piece->color == WHITE) {
-      g_game_state.white_can_castle_kingside = 0;
-      g_game_state.white_can_castle_queenside = 0;
-    } else {
-      g_game_state.black_can_castle_kingside = 0;
-      g_game_state.black_can_castle_queenside = 0;
-    }
-  } else if (selected_piece->type == ROOK) {
-    if (selected_piece->color == WHITE) {
-      if (g_game_state.selected_piece_row == 7 &&
-          g_game_state.selected_piece_col == 0) {
-        g_game_state.white_can_castle_queenside = 0;
-      } else if (g_game_state.selected_piece_row == 7 &&
-                 g_game_state.selected_piece_col == 7) {
-        g_game_state.white_can_castle_kingside = 0;
-      }
-    } else {
-      if (g_game_state.selected_piece_row == 0 &&
-          g_game_state.selected_piece_col == 0) {
-        g_game_state.black_can_castle_queenside = 0;
-      } else if (g_game_state.selected_piece_row == 0 &&
-                 g_game_state.selected_piece_col == 7) {
-        g_game_state.black_can_castle_kingside = 0;
-      }
-    }
+  cancel_engine_move();
+  start_engine_move();
+}
+
+// Play the engine's move once its search is done. Returns 1 if the board
+// changed.
+int poll_engine(void) {
+  worker_result_t result;
+  if (!worker_poll(&result) || result.id != g_game_state.engine_search ||
+      !result.done)
+    return 0;
+
+  g_game_state.engine_search = 0;
+  if (result.best == MOVE_NONE ||
+      !move_is_legal(&g_game_state.position, result.best)) {
+    printf("Engine has no move to play.\n");
+    return 0;
   }
 
-  // Move piece
-  set_piece_at(&g_game_state.board, row, col, *selected_piece);
-  clear_piece_at(&g_game_state.board, g_game_state.selected_piece_row,
-                 g_game_state.selected_piece_col);
+  char uci[6];
+  move_to_uci(result.best, uci);
+  printf("Engine plays %s (depth %d, score %d)\n", uci, result.info.depth,
+         result.info.score);
+  play_move(result.best);
+  start_ponder(&result);
+  return 1;
+}
 
-  // Switch turn
-  g_game_state.current_turn =
-      (g_game_state.current_turn == WHITE) ? BLACK : WHITE;
-  g_game_state.move_count++;
-  printf("It's now %s's turn.\n",
-         (g_game_state.current_turn == WHITE) ? "White" : "Black");
+int try_make_move(int row, int col) {
+  position_t *position = &g_game_state.position;
+  int from_row = g_game_state.ui.selected_row;
+  int from_col = g_game_state.ui.selected_col;
+  piece_t selected_piece = get_piece_at(&position->board, from_row, from_col);
+  if (selected_piece == NO_PIECE) {
+    return 0; // No piece selected
+  }
 
-  // Clear selection and possible moves
-  g_game_state.selected_piece_row = -1;
-  g_game_state.selected_piece_col = -1;
-  clear_possible_moves();
+  if (position->ply >= POSITION_MAX_PLY) {
+    printf("Move limit reached, no more moves can be recorded.\n");
+    return 0;
+  }
+
+  // Look the move up in the legal move list, which also tells us whether it
+  // is a castling, en passant or promotion move
+  int from = make_square(from_row, from_col);
+  int to = make_square(row, col);
+  move_list_t list;
+  move_t move = MOVE_NONE;
+  generate_legal_moves(position, &list);
+  for (int i = 0; i < list.count; i++) {
+    move_t candidate = list.moves[i];
+    if (move_from(candidate) == from && move_to(candidate) == to &&
+        (move_promotion(candidate) == EMPTY ||
+         move_promotion(candidate) == QUEEN)) { // Default to queen
+      move = candidate;
+      break;
+    }
+  }
+  if (move == MOVE_NONE) {
+    return 0; // Not a legal move
+  }
+
+  play_move(move);
+  engine_reply(move);
   return 1;
 }
 
@@ -364,36 +378,37 @@ void handle_mouse_click(SDL_Renderer *renderer, int x, int y) {
 
   // We clicked on an empty square or invalid square, if this is already in
   // the possible moves list; and is really a possible move, move the piece
-  if (g_game_state.possible_moves[row][col] == 1 &&
-      g_game_state.selected_piece_row != -1 &&
-      g_game_state.selected_piece_col != -1) {
+  if ((g_game_state.ui.possible_moves & square_bb(make_square(row, col))) &&
+      g_game_state.ui.selected_row != -1 &&
+      g_game_state.ui.selected_col != -1) {
     if (try_make_move(row, col))
       return;
   }
 
   find_piece_by_square(row, col);
-  if (g_game_state.selected_piece_row != -1 &&
-      g_game_state.selected_piece_col != -1) {
+  if (g_game_state.ui.selected_row != -1 &&
+      g_game_state.ui.selected_col != -1) {
 
-    if (g_game_state.board.squares[row][col].piece.color !=
-        g_game_state.current_turn) {
+    if (color_of(piece_on(&g_game_state.position.board,
+                          make_square(row, col))) !=
+        g_game_state.position.side_to_move) {
       // Selected piece is not of the current player's color; ignore
-      g_game_state.selected_piece_row = -1;
-      g_game_state.selected_piece_col = -1;
+      g_game_state.ui.selected_row = -1;
+      g_game_state.ui.selected_col = -1;
       clear_possible_moves();
       return;
     }
 
-    int sel_row = g_game_state.selected_piece_row;
-    int sel_col = g_game_state.selected_piece_col;
+    int sel_row = g_game_state.ui.selected_row;
+    int sel_col = g_game_state.ui.selected_col;
 
     get_allowed_moves(&g_game_state, sel_row, sel_col);
     return;
   }
 
   // Clicked on empty square not in possible moves; clear selection
-  g_game_state.selected_piece_row = -1;
-  g_game_state.selected_piece_col = -1;
+  g_game_state.ui.selected_row = -1;
+  g_game_state.ui.selected_col = -1;
   clear_possible_moves();
 }
 
@@ -405,9 +420,9 @@ void print_history(void) {
 
   printf("\n=== Move History ===\n");
   for (int i = 0; i < g_game_state.move_count; i++) {
-    move_history_t *move = &g_game_state.move_list[i];
+    move_history_t *entry = &g_game_state.history[i];
     char notation[16];
-    move_to_notation(move, notation, sizeof(notation));
+    move_to_notation(entry, notation, sizeof(notation));
 
     // Print move number and notation
     if (i % 2 == 0) {
@@ -438,9 +453,9 @@ void print_last_moves(int count) {
 
   printf("\n=== Last %d Moves ===\n", g_game_state.move_count - start);
   for (int i = start; i < g_game_state.move_count; i++) {
-    move_history_t *move = &g_game_state.move_list[i];
+    move_history_t *entry = &g_game_state.history[i];
     char notation[16];
-    move_to_notation(move, notation, sizeof(notation));
+    move_to_notation(entry, notation, sizeof(notation));
 
     // Print move number and notation
     if (i % 2 == 0) {
@@ -469,6 +484,8 @@ void print_help(void) {
   printf("  H - Show full move history\n");
   printf("  L - Show last 10 moves\n");
   printf("  U - Undo last move\n");
+  printf("  E - Engine plays the side to move (again to move now)\n");
+  printf("  P - Toggle pondering on your time\n");
   printf("  ? - Show this help\n");
   printf("===========================\n\n");
 }
@@ -479,88 +496,34 @@ int undo_last_move(void) {
     return 0;
   }
 
-  // Get the last move
-  move_history_t *last_move =
-      &g_game_state.move_list[g_game_state.move_count - 1];
-
-  // Handle special moves
-  if (last_move->is_castling) {
-    // Undo castling - move king back
-    set_piece_at(&g_game_state.board, last_move->from_row, last_move->from_col,
-                 last_move->moved_piece);
-    clear_piece_at(&g_game_state.board, last_move->to_row, last_move->to_col);
-
-    // Restore rook position using stored information
-    if (last_move->rook_from_row != -1 && last_move->rook_from_col != -1) {
-      set_piece_at(&g_game_state.board, last_move->rook_from_row,
-                   last_move->rook_from_col, last_move->rook_piece);
-      clear_piece_at(&g_game_state.board, last_move->rook_to_row,
-                     last_move->rook_to_col);
-    }
-  } else if (last_move->is_en_passant) {
-    // Undo en passant - restore pawn and captured pawn
-    set_piece_at(&g_game_state.board, last_move->from_row, last_move->from_col,
-                 last_move->moved_piece);
-
-    // Restore captured pawn in the correct position
-    int captured_row = (last_move->moved_piece.color == WHITE)
-                           ? last_move->to_row + 1
-                           : last_move->to_row - 1;
-    set_piece_at(&g_game_state.board, captured_row, last_move->to_col,
-                 last_move->captured_piece);
-    clear_piece_at(&g_game_state.board, last_move->to_row, last_move->to_col);
-  } else {
-    // Regular move undo
-    set_piece_at(&g_game_state.board, last_move->from_row, last_move->from_col,
-                 last_move->moved_piece);
-
-    // Restore captured piece if there was one
-    if (last_move->captured_piece.type != EMPTY) {
-      set_piece_at(&g_game_state.board, last_move->to_row, last_move->to_col,
-                   last_move->captured_piece);
-    } else {
-      // Clear the destination square if no piece was captured
-      clear_piece_at(&g_game_state.board, last_move->to_row, last_move->to_col);
-    }
-  }
-
-  // Restore castling rights if needed
-  if (last_move->moved_piece.type == KING) {
-    if (last_move->moved_piece.color == WHITE) {
-      g_game_state.white_can_castle_kingside = 1;
-      g_game_state.white_can_castle_queenside = 1;
-    } else {
-      g_game_state.black_can_castle_kingside = 1;
-      g_game_state.black_can_castle_queenside = 1;
-    }
-  } else if (last_move->moved_piece.type == ROOK) {
-    if (last_move->moved_piece.color == WHITE) {
-      if (last_move->from_row == 7 && last_move->from_col == 0) {
-        g_game_state.white_can_castle_queenside = 1;
-      } else if (last_move->from_row == 7 && last_move->from_col == 7) {
-        g_game_state.white_can_castle_kingside = 1;
-      }
-    } else {
-      if (last_move->from_row == 0 && last_move->from_col == 0) {
-        g_game_state.black_can_castle_queenside = 1;
-      } else if (last_move->from_row == 0 && last_move->from_col == 7) {
-        g_game_state.black_can_castle_kingside = 1;
-      }
-    }
+  // A search of the position being taken back is no longer wanted, and the
+  // engine sits out until E is pressed again
+  cancel_engine_move();
+  if (g_game_state.engine_color != NONE) {
+    g_game_state.engine_color = NONE;
+    printf("Engine off, press E to let it play.\n");
   }
 
-  // Switch turn back
-  g_game_state.current_turn =
-      (g_game_state.current_turn == WHITE) ? BLACK : WHITE;
+  // The position restores the board, castling rights and en passant state
+  unmake_move(&g_game_state.position);
   g_game_state.move_count--;
 
+  // The side that gets the move back returns the increment it was credited
+  // for it; otherwise clocks keep what they had. Whatever ended the game,
+  // flag fall included, happened after this position.
+  int side = g_game_state.position.side_to_move;
+  if (GAME_CLOCK > 0)
+    g_game_state.clock[side] -= GAME_INCREMENT;
+  g_game_state.turn_start = SDL_GetTicks();
+  g_game_state.game_over = 0;
+
   // Clear selection and possible moves
-  g_game_state.selected_piece_row = -1;
-  g_game_state.selected_piece_col = -1;
+  g_game_state.ui.selected_row = -1;
+  g_game_state.ui.selected_col = -1;
   clear_possible_moves();
 
   printf("Undid last move. It's now %s's turn.\n",
-         (g_game_state.current_turn == WHITE) ? "White" : "Black");
+         (g_game_state.position.side_to_move == WHITE) ? "White" : "Black");
   return 1;
 }
 
@@ -568,12 +531,60 @@ void update_state(SDL_Renderer *renderer) {
   if (g_game_state.move_count == -1) {
     printf("Game started. White's turn.\n");
     g_game_state.move_count++;
+    g_game_state.turn_start = SDL_GetTicks();
+  }
+
+  int side = g_game_state.position.side_to_move;
+  if (GAME_CLOCK > 0 && !g_game_state.game_over &&
+      clock_remaining(side) == 0) {
+    cancel_engine_move();
+    g_game_state.game_over = (side == WHITE) ? 2 : 1;
+    printf("%s ran out of time, %s wins.\n",
+           (side == WHITE) ? "White" : "Black",
+           (side == WHITE) ? "Black" : "White");
+  }
+
+  if (poll_engine()) {
+    g_game_state.ui.render_needed = 1; // Mark for re-render
+  }
+
+  if (g_game_state.input_state->engine_move) {
+    g_game_state.input_state->engine_move = 0;
+    if (g_game_state.game_over) {
+      printf("The game is over.\n");
+    } else if (g_game_state.engine_search != 0 &&
+               !g_game_state.engine_pondering) {
+      worker_stop(); // Move now with the best move found so far
+    } else {
+      cancel_engine_move();
+      g_game_state.engine_color = g_game_state.position.side_to_move;
+      start_engine_move();
+    }
+  }
+
+  if (g_game_state.input_state->toggle_ponder) {
+    g_game_state.input_state->toggle_ponder = 0;
+    g_game_state.ponder = !g_game_state.ponder;
+    if (!g_game_state.ponder && g_game_state.engine_pondering) {
+      cancel_engine_move();
+    }
+    printf("Pondering %s.\n", g_game_state.ponder ? "on" : "off");
   }
 
   if (g_game_state.input_state->mouse_clicked) {
-    handle_mouse_click(renderer, g_game_state.input_state->mouse_x,
-                       g_game_state.input_state->mouse_y);
-    g_game_state.render_needed = 1; // Mark for re-render
+    if (g_game_state.game_over) {
+      g_game_state.input_state->mouse_clicked = 0;
+      printf("The game is over.\n");
+    } else if (g_game_state.engine_search != 0 &&
+               !g_game_state.engine_pondering) {
+      // The board belongs to the engine until it has moved
+      g_game_state.input_state->mouse_clicked = 0;
+      printf("Engine is thinking, press E to make it move now.\n");
+    } else {
+      handle_mouse_click(renderer, g_game_state.input_state->mouse_x,
+                         g_game_state.input_state->mouse_y);
+      g_game_state.ui.render_needed = 1; // Mark for re-render
+    }
   }
 
   if (g_game_state.input_state->print_history) {
@@ -584,7 +595,7 @@ void update_state(SDL_Renderer *renderer) {
   if (g_game_state.input_state->undo_move) {
     g_game_state.input_state->undo_move = 0;
     if (undo_last_move()) {
-      g_game_state.render_needed = 1; // Mark for re-render
+      g_game_state.ui.render_needed = 1; // Mark for re-render
     }
   }
 
@@ -2,60 +2,41 @@
 #define GAME_H
 
 #include <SDL2/SDL.h>
+#include "position.h"
 #include "config.h"
 #include "input.h"
 
+// One played move, as kept for the history printout. Everything else about
+// the move (squares, castling, en passant, promotion) is in the packed move.
 typedef struct {
-  int type; // 0 = empty, 1 = pawn, 2 = knight, etc.
-  int color; // 0 = none, 1 = white, 2 = black
-  int theme; // 0 = standard, 1 = wood
-} piece_t;
-
-typedef struct {
-  piece_t piece;
-  int column; // 0-7
-  int row;    // 0-7
-} square_t;
-
-typedef struct {
-  square_t squares[8][8];
-} board_t;
+  move_t move;
+  uint8_t moved_piece;    // Piece type that moved
+  uint8_t captured_piece; // Piece type captured, EMPTY if no capture
+} move_history_t;
 
+// What the board UI shows on top of the position
 typedef struct {
-  int from_row;
-  int from_col;
-  int to_row;
-  int to_col;
-  piece_t moved_piece;
-  piece_t captured_piece; // type = EMPTY if no capture
-  int is_castling; // 1 = castling move, 0 = normal move
-  int is_en_passant; // 1 = en passant capture, 0 = normal move
-  int is_promotion; // 1 = pawn promotion, 0 = normal move
-  int promotion_piece; // piece type for promotion (if is_promotion = 1)
-  // Castling-specific fields
-  int rook_from_row;
-  int rook_from_col;
-  int rook_to_row;
-  int rook_to_col;
-  piece_t rook_piece;
-} move_history_t;
+  int selected_row; // -1 if no piece is selected
+  int selected_col;
+  bitboard_t possible_moves; // Target squares of the selected piece
+  int theme;                 // Sprite theme for all pieces, THEME_*
+  int render_needed;         // 1 = needs re-render, 0 = no changes
+} ui_state_t;
 
 typedef struct {
-  board_t board;
-  int current_turn; // 1 = white, 2 = black
+  position_t position; // Board, side to move, castling and en passant state
+  ui_state_t ui;
   int move_count;
   int game_over; // 0 = ongoing, 1 = white wins, 2 = black wins, 3 = draw
-  int render_needed; // 1 = needs re-render, 0 = no changes
-  int selected_piece_row;
-  int selected_piece_col;
-  int possible_moves[8][8]; // 1 = possible move, 0 = not possible
-  move_history_t move_list[1024]; // Store up to 1024 moves; realistically this is more than enough
+  int64_t clock[COLOR_COUNT]; // Milliseconds left at the start of the turn
+  Uint32 turn_start;          // SDL ticks when the side to move started
+  move_history_t history[POSITION_MAX_PLY]; // Same capacity as the position's undo stack
   input_state_t *input_state;
-  // Castling rights: 1 = can castle, 0 = cannot castle
-  int white_can_castle_kingside;
-  int white_can_castle_queenside;
-  int black_can_castle_kingside;
-  int black_can_castle_queenside;
+  int engine_color;       // Side the engine plays, NONE if it is off
+  uint32_t engine_search; // Ticket of the engine's running search, 0 if idle
+  int ponder;             // Think on the opponent's time
+  int engine_pondering;   // engine_search assumes the opponent plays...
+  move_t ponder_move;     // ...this move
 } game_state_t;
 
 // Game state functions
@@ -63,6 +44,7 @@ void update_state(SDL_Renderer* renderer);
 game_state_t* init_game_state(void);
 void cleanup_game_state(void);
 int undo_last_move(void);
+int64_t clock_remaining(int color);
 void print_last_moves(int count);
 void print_help(void);
 
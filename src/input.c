@@ -11,6 +11,8 @@ void init_input_state(input_state_t *state) {
   state->undo_move = 0;
   state->show_last_moves = 0;
   state->show_help = 0;
+  state->engine_move = 0;
+  state->toggle_ponder = 0;
   state->pause = 0;
   state->mouse_x = 0;
   state->mouse_y = 0;
@@ -56,6 +58,12 @@ void handle_keydown_event(input_state_t *state, SDL_Keysym keysym) {
   case SDLK_SLASH:
     state->show_help = 1;
     break;
+  case SDLK_e:
+    state->engine_move = 1;
+    break;
+  case SDLK_p:
+    state->toggle_ponder = 1;
+    break;
   default:
     break;
   }
@@ -11,6 +11,8 @@ typedef struct {
     int undo_move;
     int show_last_moves;
     int show_help;
+    int engine_move;
+    int toggle_ponder;
     int pause;
     int mouse_x;
     int mouse_y;
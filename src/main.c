@@ -2,8 +2,11 @@
 #include "engine.h"
 #include "game.h"
 #include "input.h"
+#include "nnue.h"
+#include "params.h"
 #include "renderer.h"
 #include "resources.h"
+#include "worker.h"
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_events.h>
 #include <SDL2/SDL_keycode.h>
@@ -11,6 +14,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <time.h>
+#include <unistd.h>
 
 void render_game(SDL_Renderer *renderer, game_state_t *state) {
   // Clear
@@ -19,8 +23,9 @@ void render_game(SDL_Renderer *renderer, game_state_t *state) {
   // Draw
   draw_background(renderer);
   draw_board(renderer);
-  draw_all_pieces(renderer, &state->board);
-  draw_possible_moves(renderer, state->possible_moves, &state->board);
+  draw_all_pieces(renderer, &state->position.board, state->ui.theme);
+  draw_possible_moves(renderer, state->ui.possible_moves,
+                      &state->position.board);
 
   // Present the rendered frame
   SDL_RenderPresent(renderer);
@@ -35,12 +40,12 @@ void game_loop(input_state_t *current_state, SDL_Renderer *renderer,
   update_state(renderer);
 
   // 3. Render if called for
-  if (!state->render_needed) {
+  if (!state->ui.render_needed) {
     return;
   }
 
   render_game(renderer, state);
-  state->render_needed = 0; // Reset render flag for next frame
+  state->ui.render_needed = 0; // Reset render flag for next frame
 }
 
 int calculate_fps(Uint32 *last_frame_time, int *frame_count) {
@@ -84,6 +89,29 @@ int main(void) {
     return 1;
   }
 
+  // Before the game sets up its board, which totals the piece-square tables.
+  // Like the network, tuned parameters are optional.
+  if (access(ENGINE_PARAMS_FILE, R_OK) == 0 &&
+      params_load(ENGINE_PARAMS_FILE) != ERROR_NONE) {
+    printf("Engine uses its built-in evaluation parameters\n");
+  }
+  // The network is optional; only a file that fails to load is reported
+  if (access(ENGINE_NNUE_FILE, R_OK) == 0 &&
+      nnue_load(ENGINE_NNUE_FILE) != ERROR_NONE) {
+    printf("Engine evaluates with piece-square tables\n");
+  }
+
+  // Leave a core to the frame loop; the engine gets the rest
+  int engine_threads = SDL_GetCPUCount() - 1;
+  result = init_worker(ENGINE_HASH_MB, engine_threads > 0 ? engine_threads : 1);
+  if (result != ERROR_NONE) {
+    fprintf(stderr, "Failed to initialize engine worker: %d\n", result);
+    cleanup_resources();
+    cleanup_renderer();
+    cleanup_engine(win, renderer);
+    return 1;
+  }
+
   game_state_t *state = init_game_state();
 
   // Allocate input state
@@ -91,6 +119,7 @@ int main(void) {
   if (current_state == NULL) {
     fprintf(stderr, "Failed to allocate memory for input_state_t\n");
     cleanup_game_state();
+    cleanup_worker();
     cleanup_resources();
     cleanup_renderer();
     cleanup_engine(win, renderer);
@@ -107,8 +136,17 @@ int main(void) {
   while (!current_state->exit_trigger) {
     int fps = calculate_fps(&last_frame_time, &frame_count);
     if (fps != -1) {
-      char title[50];
-      snprintf(title, sizeof(title), "C-Hess - FPS: %d", fps);
+      char title[96];
+      if (GAME_CLOCK > 0) {
+        int64_t white = clock_remaining(WHITE) / 1000;
+        int64_t black = clock_remaining(BLACK) / 1000;
+        snprintf(title, sizeof(title),
+                 "C-Hess - FPS: %d - White %d:%02d Black %d:%02d", fps,
+                 (int)(white / 60), (int)(white % 60), (int)(black / 60),
+                 (int)(black % 60));
+      } else {
+        snprintf(title, sizeof(title), "C-Hess - FPS: %d", fps);
+      }
       SDL_SetWindowTitle(win, title);
     }
 
@@ -125,6 +163,7 @@ int main(void) {
   // Cleanup
   free(current_state);
   cleanup_game_state();
+  cleanup_worker();
   cleanup_resources();
   cleanup_renderer();
   cleanup_engine(win, renderer);
@@ -0,0 +1,55 @@
+#ifndef MOVE_H
+#define MOVE_H
+
+#include "board.h"
+#include <stdint.h>
+
+// Special move kinds, stored in the top two bits of a move
+enum {
+  MOVE_NORMAL = 0,
+  MOVE_CASTLING = 1,   // King move of two columns, the rook follows
+  MOVE_EN_PASSANT = 2, // Pawn capture onto the en passant square
+  MOVE_PROMOTION = 3   // Pawn reaching the last row, see move_promotion()
+};
+
+// A move packed into 16 bits:
+//   bits  0-5   origin square (see bitboard.h)
+//   bits  6-11  target square
+//   bits 12-13  promotion piece, counted from KNIGHT (only for promotions)
+//   bits 14-15  MOVE_NORMAL, MOVE_CASTLING, ...
+// The value 0 (a8 to a8) can never be a real move and marks "no move".
+typedef uint16_t move_t;
+
+#define MOVE_NONE ((move_t)0)
+
+// No legal chess position has more than 218 moves
+#define MAX_MOVES 256
+
+// Fixed-capacity move buffer, meant to live on the stack
+typedef struct {
+  move_t moves[MAX_MOVES];
+  int count;
+} move_list_t;
+
+// promotion is KNIGHT, ROOK, BISHOP or QUEEN (consecutive piece types) for
+// promotions and ignored otherwise
+static inline move_t new_move(int from, int to, int promotion, int flags) {
+  int promotion_bits = (flags == MOVE_PROMOTION) ? promotion - KNIGHT : 0;
+  return (move_t)(from | (to << 6) | (promotion_bits << 12) | (flags << 14));
+}
+
+static inline int move_from(move_t move) { return move & 63; }
+static inline int move_to(move_t move) { return (move >> 6) & 63; }
+static inline int move_flags(move_t move) { return move >> 14; }
+
+// Piece type a promotion produces, EMPTY for other moves
+static inline int move_promotion(move_t move) {
+  return (move_flags(move) == MOVE_PROMOTION) ? ((move >> 12) & 3) + KNIGHT
+                                               : EMPTY;
+}
+
+static inline void move_list_add(move_list_t *list, move_t move) {
+  list->moves[list->count++] = move;
+}
+
+#endif // MOVE_H
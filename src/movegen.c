@@ -0,0 +1,399 @@
+#include "movegen.h"
+#include "attacks.h"
+
+// The generators below take the side to move as a parameter that is always a
+// compile-time constant: generate_moves() picks one of two fully inlined
+// copies, so pawn directions, the promotion row and the castling squares fold
+// into constants and the inner loops never test the color.
+#define SIDE_INLINE static inline __attribute__((always_inline))
+
+// Check and pin information shared by every piece's generator
+typedef struct {
+  int king;            // Square of our king
+  bitboard_t checkers; // Enemy pieces giving check
+  bitboard_t pinned;   // Our pieces pinned against our king
+  bitboard_t evasion;  // Squares that resolve a check, all if not in check
+  bitboard_t target;   // Squares a non-king move may land on
+  int type;            // GEN_ALL, GEN_CAPTURES or GEN_QUIETS
+} legality_t;
+
+// Pawn geometry for one side
+#define FORWARD(us) (((us) == WHITE) ? -8 : 8)
+#define PROMOTION_ROW(us) (((us) == WHITE) ? ROW_0 : ROW_7)
+#define HOME_ROW(us) (((us) == WHITE) ? 7 : 0)
+
+// Move every bit of bb by offset squares, towards higher squares if positive
+static inline bitboard_t shift(bitboard_t bb, int offset) {
+  return (offset > 0) ? bb << offset : bb >> -offset;
+}
+
+static bitboard_t find_pinned(const board_t *board, int us, int king) {
+  int them = opponent_of(us);
+  const bitboard_t *enemy = board->pieces[them];
+
+  // Enemy sliders that would attack the king if our pieces were not there
+  bitboard_t snipers =
+      (rook_attacks(king, board->occupied[them]) &
+       (enemy[ROOK] | enemy[QUEEN])) |
+      (bishop_attacks(king, board->occupied[them]) &
+       (enemy[BISHOP] | enemy[QUEEN]));
+
+  bitboard_t pinned = 0;
+  while (snipers) {
+    int sniper = pop_lsb(&snipers);
+    bitboard_t blockers = between_bb[king][sniper] & board->occupied[NONE];
+    // Exactly one piece in between, and it is ours
+    if (blockers && !(blockers & (blockers - 1)) &&
+        (blockers & board->occupied[us])) {
+      pinned |= blockers;
+    }
+  }
+  return pinned;
+}
+
+// A pinned piece may only move along the line through it and its king
+static inline int keeps_pin(const legality_t *l, int from, int to) {
+  return !(l->pinned & square_bb(from)) ||
+         (line_bb[l->king][from] & square_bb(to));
+}
+
+static void add_piece_moves(move_list_t *list, int from,
+                            bitboard_t targets) {
+  while (targets) {
+    int to = pop_lsb(&targets);
+    move_list_add(list, new_move(from, to, EMPTY, MOVE_NORMAL));
+  }
+}
+
+static void add_promotions(move_list_t *list, int from, int to) {
+  move_list_add(list, new_move(from, to, QUEEN, MOVE_PROMOTION));
+  move_list_add(list, new_move(from, to, ROOK, MOVE_PROMOTION));
+  move_list_add(list, new_move(from, to, BISHOP, MOVE_PROMOTION));
+  move_list_add(list, new_move(from, to, KNIGHT, MOVE_PROMOTION));
+}
+
+// Emit pawn moves for a whole set of targets at once; offset is the distance
+// from the origin square to the target square. Promotions are handled by the
+// caller, so these are all plain moves.
+static inline void add_pawn_moves(const legality_t *l, move_list_t *list,
+                                  bitboard_t targets, int offset) {
+  while (targets) {
+    int to = pop_lsb(&targets);
+    int from = to - offset;
+    if (keeps_pin(l, from, to))
+      move_list_add(list, new_move(from, to, EMPTY, MOVE_NORMAL));
+  }
+}
+
+static void add_pawn_promotions(const legality_t *l, move_list_t *list,
+                                bitboard_t targets, int offset) {
+  while (targets) {
+    int to = pop_lsb(&targets);
+    int from = to - offset;
+    if (keeps_pin(l, from, to))
+      add_promotions(list, from, to);
+  }
+}
+
+SIDE_INLINE void generate_pawn_moves(const position_t *pos,
+                                     const legality_t *l, move_list_t *list,
+                                     const int us) {
+  const int them = (us == WHITE) ? BLACK : WHITE;
+  const int forward = FORWARD(us);
+  const bitboard_t promotion_row = PROMOTION_ROW(us);
+  // Pawns that can still make a double step, after their single step
+  const bitboard_t double_row = (us == WHITE) ? (ROW_0 << 40) : (ROW_0 << 16);
+
+  const board_t *board = &pos->board;
+  bitboard_t pawns = board->pieces[us][PAWN];
+  bitboard_t empty = ~board->occupied[NONE];
+  bitboard_t enemies = board->occupied[them];
+
+  // Pushes onto the last row count as captures, pawn captures are never quiet
+  bitboard_t push_target = l->evasion;
+  bitboard_t capture_target = l->evasion;
+  if (l->type == GEN_CAPTURES) {
+    push_target &= promotion_row;
+  } else if (l->type == GEN_QUIETS) {
+    push_target &= ~promotion_row;
+    capture_target = 0;
+  }
+
+  // Pushes and captures are computed set-wise for all pawns, then filtered
+  // through the check target and the pins
+  bitboard_t single = shift(pawns, forward) & empty;
+  bitboard_t twice = shift(single & double_row, forward) & empty;
+  bitboard_t left = shift(pawns & ~COL_A, forward - 1) & enemies;
+  bitboard_t right = shift(pawns & ~COL_H, forward + 1) & enemies;
+
+  single &= push_target;
+  left &= capture_target;
+  right &= capture_target;
+
+  add_pawn_moves(l, list, single & ~promotion_row, forward);
+  add_pawn_moves(l, list, twice & push_target, 2 * forward);
+  add_pawn_moves(l, list, left & ~promotion_row, forward - 1);
+  add_pawn_moves(l, list, right & ~promotion_row, forward + 1);
+
+  if ((single | left | right) & promotion_row) {
+    add_pawn_promotions(l, list, single & promotion_row, forward);
+    add_pawn_promotions(l, list, left & promotion_row, forward - 1);
+    add_pawn_promotions(l, list, right & promotion_row, forward + 1);
+  }
+
+  if (pos->ep_square == SQUARE_NONE || l->type == GEN_QUIETS)
+    return;
+
+  // En passant removes two pawns from one row at once, which can expose the
+  // king along that row, so test the resulting slider attacks directly
+  int ep = pos->ep_square;
+  int captured = ep - forward;
+  const bitboard_t *enemy = board->pieces[them];
+  bitboard_t candidates = pawn_attacks[them][ep] & pawns;
+  while (candidates) {
+    int from = pop_lsb(&candidates);
+    bitboard_t occupied = (board->occupied[NONE] ^ square_bb(from) ^
+                           square_bb(captured)) |
+                          square_bb(ep);
+
+    if (rook_attacks(l->king, occupied) & (enemy[ROOK] | enemy[QUEEN]))
+      continue;
+    if (bishop_attacks(l->king, occupied) & (enemy[BISHOP] | enemy[QUEEN]))
+      continue;
+    // A knight or another pawn giving check is not resolved by the capture
+    if (l->checkers & ~square_bb(captured) & (enemy[KNIGHT] | enemy[PAWN]))
+      continue;
+
+    move_list_add(list, new_move(from, ep, EMPTY, MOVE_EN_PASSANT));
+  }
+}
+
+SIDE_INLINE void generate_piece_moves(const position_t *pos,
+                                      const legality_t *l, move_list_t *list,
+                                      const int us) {
+  const board_t *board = &pos->board;
+  const bitboard_t *ours = board->pieces[us];
+  bitboard_t occupied = board->occupied[NONE];
+
+  // A pinned knight can never stay on the pin line
+  bitboard_t knights = ours[KNIGHT] & ~l->pinned;
+  while (knights) {
+    int from = pop_lsb(&knights);
+    add_piece_moves(list, from, knight_attacks[from] & l->target);
+  }
+
+  bitboard_t diagonal = ours[BISHOP] | ours[QUEEN];
+  while (diagonal) {
+    int from = pop_lsb(&diagonal);
+    bitboard_t targets = bishop_attacks(from, occupied) & l->target;
+    if (l->pinned & square_bb(from))
+      targets &= line_bb[l->king][from];
+    add_piece_moves(list, from, targets);
+  }
+
+  bitboard_t straight = ours[ROOK] | ours[QUEEN];
+  while (straight) {
+    int from = pop_lsb(&straight);
+    bitboard_t targets = rook_attacks(from, occupied) & l->target;
+    if (l->pinned & square_bb(from))
+      targets &= line_bb[l->king][from];
+    add_piece_moves(list, from, targets);
+  }
+}
+
+SIDE_INLINE void generate_king_moves(const position_t *pos,
+                                     const legality_t *l, move_list_t *list,
+                                     const int us) {
+  const int them = (us == WHITE) ? BLACK : WHITE;
+  const int row = HOME_ROW(us);
+  const int kingside =
+      (us == WHITE) ? CASTLE_WHITE_KINGSIDE : CASTLE_BLACK_KINGSIDE;
+  const int queenside =
+      (us == WHITE) ? CASTLE_WHITE_QUEENSIDE : CASTLE_BLACK_QUEENSIDE;
+
+  const board_t *board = &pos->board;
+  bitboard_t enemies = board->occupied[them];
+
+  // Sliders must see through the king, or it could step back along a
+  // checking ray
+  bitboard_t occupied = board->occupied[NONE] ^ square_bb(l->king);
+  bitboard_t targets = king_attacks[l->king] & ~board->occupied[us];
+  if (l->type == GEN_CAPTURES)
+    targets &= enemies;
+  else if (l->type == GEN_QUIETS)
+    targets &= ~enemies;
+  while (targets) {
+    int to = pop_lsb(&targets);
+    if (!(attackers_to(board, to, occupied) & enemies)) {
+      move_list_add(list, new_move(l->king, to, EMPTY, MOVE_NORMAL));
+    }
+  }
+
+  // Can't castle while in check, or once the king has left its square
+  if (l->type == GEN_CAPTURES || l->checkers ||
+      !(pos->castling & (kingside | queenside)) ||
+      l->king != make_square(row, 4))
+    return;
+
+  bitboard_t rooks = board->pieces[us][ROOK];
+  occupied = board->occupied[NONE];
+
+  // The squares between king and rook must be empty, and the squares the
+  // king crosses must not be attacked
+  if ((pos->castling & kingside) && (rooks & square_bb(make_square(row, 7))) &&
+      !(between_bb[l->king][make_square(row, 7)] & occupied) &&
+      !is_square_attacked(board, make_square(row, 5), them) &&
+      !is_square_attacked(board, make_square(row, 6), them)) {
+    move_list_add(list,
+                  new_move(l->king, make_square(row, 6), EMPTY, MOVE_CASTLING));
+  }
+
+  if ((pos->castling & queenside) && (rooks & square_bb(make_square(row, 0))) &&
+      !(between_bb[l->king][make_square(row, 0)] & occupied) &&
+      !is_square_attacked(board, make_square(row, 3), them) &&
+      !is_square_attacked(board, make_square(row, 2), them)) {
+    move_list_add(list,
+                  new_move(l->king, make_square(row, 2), EMPTY, MOVE_CASTLING));
+  }
+}
+
+SIDE_INLINE int generate_side(const position_t *pos, move_list_t *list,
+                              int type, const int us) {
+  const int them = (us == WHITE) ? BLACK : WHITE;
+  const board_t *board = &pos->board;
+  legality_t l;
+
+  list->count = 0;
+  if (!board->pieces[us][KING])
+    return 0;
+
+  l.type = type;
+  l.king = lsb(board->pieces[us][KING]);
+  l.checkers = attackers_to(board, l.king, board->occupied[NONE]) &
+               board->occupied[them];
+  l.pinned = find_pinned(board, us, l.king);
+
+  generate_king_moves(pos, &l, list, us);
+
+  // In double check only the king can move
+  if (l.checkers & (l.checkers - 1))
+    return list->count;
+
+  // In single check the other pieces must capture the checker or block it
+  l.evasion = ~(bitboard_t)0;
+  if (l.checkers) {
+    int checker = lsb(l.checkers);
+    l.evasion = between_bb[l.king][checker] | l.checkers;
+  }
+
+  l.target = l.evasion & ~board->occupied[us];
+  if (type == GEN_CAPTURES)
+    l.target &= board->occupied[them];
+  else if (type == GEN_QUIETS)
+    l.target &= ~board->occupied[them];
+
+  generate_pawn_moves(pos, &l, list, us);
+  generate_piece_moves(pos, &l, list, us);
+  return list->count;
+}
+
+int generate_moves(const position_t *pos, move_list_t *list, int type) {
+  if (pos->side_to_move == WHITE)
+    return generate_side(pos, list, type, WHITE);
+  return generate_side(pos, list, type, BLACK);
+}
+
+int generate_legal_moves(const position_t *pos, move_list_t *list) {
+  return generate_moves(pos, list, GEN_ALL);
+}
+
+// Squares a piece of the given type on from could move to on an otherwise
+// unobstructed board, pawn moves excluded
+static bitboard_t piece_targets(int type, int from, bitboard_t occupied) {
+  if (type == KNIGHT)
+    return knight_attacks[from];
+  if (type == BISHOP)
+    return bishop_attacks(from, occupied);
+  if (type == ROOK)
+    return rook_attacks(from, occupied);
+  if (type == QUEEN)
+    return queen_attacks(from, occupied);
+  if (type == KING)
+    return king_attacks[from];
+  return 0;
+}
+
+int move_is_legal(const position_t *pos, move_t move) {
+  const board_t *board = &pos->board;
+  int us = pos->side_to_move;
+  int them = opponent_of(us);
+  int from = move_from(move);
+  int to = move_to(move);
+  int flags = move_flags(move);
+  piece_t piece = piece_on(board, from);
+
+  // Only new_move() encodings are accepted, so a legal move has one form
+  if (flags != MOVE_PROMOTION && (move >> 12) & 3)
+    return 0;
+
+  if (move == MOVE_NONE || color_of(piece) != us ||
+      (board->occupied[us] & square_bb(to)) || !board->pieces[us][KING])
+    return 0;
+
+  // Castling and en passant are rare enough to just look up
+  if (flags == MOVE_CASTLING || flags == MOVE_EN_PASSANT) {
+    move_list_t list;
+    generate_moves(pos, &list, GEN_ALL);
+    for (int i = 0; i < list.count; i++) {
+      if (list.moves[i] == move)
+        return 1;
+    }
+    return 0;
+  }
+
+  bitboard_t occupied = board->occupied[NONE];
+  bitboard_t to_bb = square_bb(to);
+
+  if (type_of(piece) == PAWN) {
+    bitboard_t promotion_row = PROMOTION_ROW(us);
+    bitboard_t start_row = (us == WHITE) ? (ROW_0 << 48) : (ROW_0 << 8);
+    int forward = FORWARD(us);
+
+    if ((flags == MOVE_PROMOTION) != ((to_bb & promotion_row) != 0))
+      return 0;
+
+    int single = (to == from + forward) && !(occupied & to_bb);
+    int twice = (to == from + 2 * forward) &&
+                (square_bb(from) & start_row) &&
+                !(occupied & (to_bb | square_bb(from + forward)));
+    int capture =
+        (pawn_attacks[us][from] & board->occupied[them] & to_bb) != 0;
+    if (!single && !twice && !capture)
+      return 0;
+  } else {
+    if (flags == MOVE_PROMOTION ||
+        !(piece_targets(type_of(piece), from, occupied) & to_bb))
+      return 0;
+  }
+
+  // The move is possible; it is legal if it leaves our king unattacked. A
+  // piece captured on the target square no longer attacks anything.
+  int king = (type_of(piece) == KING) ? to : lsb(board->pieces[us][KING]);
+  occupied = (occupied ^ square_bb(from)) | to_bb;
+  return !(attackers_to(board, king, occupied) & board->occupied[them] &
+           ~to_bb);
+}
+
+void move_to_uci(move_t move, char *out) {
+  static const char promotion_chars[PIECE_TYPE_COUNT] = {0,   0,   'n', 'r',
+                                                         'b', 'q', 0};
+  int from = move_from(move);
+  int to = move_to(move);
+
+  out[0] = (char)('a' + square_col(from));
+  out[1] = (char)('8' - square_row(from));
+  out[2] = (char)('a' + square_col(to));
+  out[3] = (char)('8' - square_row(to));
+  out[4] = promotion_chars[move_promotion(move)];
+  out[5] = '\0';
+}
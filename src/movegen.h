@@ -0,0 +1,25 @@
+#ifndef MOVEGEN_H
+#define MOVEGEN_H
+
+#include "move.h"
+#include "position.h"
+
+// Which part of the legal moves to generate. Captures are all captures,
+// en passant and promotions; quiets are every other move, castling included.
+enum { GEN_ALL, GEN_CAPTURES, GEN_QUIETS };
+
+// Fill list with every strictly legal move of the given kind for the side to
+// move and return how many there are. Pins and checks are worked out once up
+// front, so no move has to be made and taken back to test it.
+int generate_moves(const position_t *pos, move_list_t *list, int type);
+int generate_legal_moves(const position_t *pos, move_list_t *list);
+
+// Whether move, typically from a table or another position, is legal here.
+// Cheaper than generating the moves and looking it up.
+int move_is_legal(const position_t *pos, move_t move);
+
+// Write move in coordinate notation (e2e4, e7e8q) into out, which must hold
+// at least 6 characters
+void move_to_uci(move_t move, char *out);
+
+#endif // MOVEGEN_H
@@ -0,0 +1,316 @@
+#include "movepick.h"
+#include "attacks.h"
+#include "movegen.h"
+#include <string.h>
+
+// Rough piece values for ordering captures, indexed by piece type
+static const int piece_value[PIECE_TYPE_COUNT] = {0, 100, 300, 500, 300, 900,
+                                                  10000};
+
+// The quiet move that refuted the opponent's last move, if it is known
+static move_t countermove(const history_t *history, const position_t *pos) {
+  if (!history || pos->ply == 0 ||
+      pos->history[pos->ply - 1].move == MOVE_NONE)
+    return MOVE_NONE;
+
+  int to = move_to(pos->history[pos->ply - 1].move);
+  piece_t moved = piece_on(&pos->board, to);
+  return history->countermoves[color_of(moved)][type_of(moved)][to];
+}
+
+void move_picker_init(move_picker_t *mp, const position_t *pos,
+                      move_t tt_move, const move_t *killers,
+                      const history_t *history) {
+  mp->pos = pos;
+  mp->history = history;
+  mp->captures_only = 0;
+  mp->stage = STAGE_TT_MOVE;
+  mp->tt_move = tt_move;
+  mp->refutations[0] = killers ? killers[0] : MOVE_NONE;
+  mp->refutations[1] = killers ? killers[1] : MOVE_NONE;
+  mp->refutations[2] = countermove(history, pos);
+  mp->refutation_index = 0;
+  mp->list.count = 0;
+  mp->index = 0;
+  mp->bad_captures.count = 0;
+  mp->bad_index = 0;
+}
+
+void move_picker_init_captures(move_picker_t *mp, const position_t *pos,
+                               move_t tt_move) {
+  // Only moves the quiescence search would try: captures and queen
+  // promotions
+  int is_promotion = move_flags(tt_move) == MOVE_PROMOTION;
+  if (tt_move != MOVE_NONE &&
+      (is_promotion ? move_promotion(tt_move) != QUEEN
+                    : !move_is_capture(pos, tt_move)))
+    tt_move = MOVE_NONE;
+
+  move_picker_init(mp, pos, tt_move, NULL, NULL);
+  mp->captures_only = 1;
+}
+
+static int is_refutation(const move_picker_t *mp, move_t move) {
+  return move == mp->refutations[0] || move == mp->refutations[1] ||
+         move == mp->refutations[2];
+}
+
+// MVV-LVA: most valuable victim first, least valuable attacker breaking
+// ties. Captures that lose material in the exchange are set aside as bad
+// captures, and so are under-promotions, which are rarely better than the
+// queen. The quiescence search stops before the bad captures, so it only
+// ever tries queen promotions.
+static void score_captures(move_picker_t *mp) {
+  const board_t *board = &mp->pos->board;
+  int kept = 0;
+
+  for (int i = 0; i < mp->list.count; i++) {
+    move_t move = mp->list.moves[i];
+    if (move == mp->tt_move)
+      continue;
+
+    if (move_flags(move) == MOVE_PROMOTION && move_promotion(move) != QUEEN) {
+      move_list_add(&mp->bad_captures, move);
+      continue;
+    }
+
+    int attacker = type_of(piece_on(board, move_from(move)));
+    int victim = (move_flags(move) == MOVE_EN_PASSANT)
+                     ? PAWN
+                     : type_of(piece_on(board, move_to(move)));
+    int gain = piece_value[victim] + piece_value[move_promotion(move)];
+
+    if (!see_ge(mp->pos, move, 0)) {
+      move_list_add(&mp->bad_captures, move);
+      continue;
+    }
+
+    mp->list.moves[kept] = move;
+    mp->scores[kept] = gain * 16 - piece_value[attacker] / 100;
+    kept++;
+  }
+  mp->list.count = kept;
+}
+
+// Quiet moves by butterfly history; the table move and refutations were
+// already tried and are dropped
+static void score_quiets(move_picker_t *mp) {
+  int us = mp->pos->side_to_move;
+  int kept = 0;
+
+  for (int i = 0; i < mp->list.count; i++) {
+    move_t move = mp->list.moves[i];
+    if (move == mp->tt_move || is_refutation(mp, move))
+      continue;
+
+    mp->list.moves[kept] = move;
+    mp->scores[kept] =
+        mp->history
+            ? mp->history->butterfly[us][move_from(move)][move_to(move)]
+            : 0;
+    kept++;
+  }
+  mp->list.count = kept;
+}
+
+// Take the best scored move left in the list. A full sort would be wasted on
+// nodes that cut off after one or two moves.
+static move_t pick_best(move_picker_t *mp) {
+  int best = mp->index;
+  for (int i = mp->index + 1; i < mp->list.count; i++) {
+    if (mp->scores[i] > mp->scores[best])
+      best = i;
+  }
+
+  move_t move = mp->list.moves[best];
+  int score = mp->scores[best];
+  mp->list.moves[best] = mp->list.moves[mp->index];
+  mp->scores[best] = mp->scores[mp->index];
+  mp->list.moves[mp->index] = move;
+  mp->scores[mp->index] = score;
+  mp->index++;
+  return move;
+}
+
+move_t next_move(move_picker_t *mp) {
+  for (;;) {
+    switch (mp->stage) {
+    case STAGE_TT_MOVE:
+      mp->stage = STAGE_CAPTURES_INIT;
+      if (mp->tt_move != MOVE_NONE && move_is_legal(mp->pos, mp->tt_move))
+        return mp->tt_move;
+      mp->tt_move = MOVE_NONE;
+      break;
+
+    case STAGE_CAPTURES_INIT:
+      generate_moves(mp->pos, &mp->list, GEN_CAPTURES);
+      score_captures(mp);
+      mp->index = 0;
+      mp->stage = STAGE_GOOD_CAPTURES;
+      break;
+
+    case STAGE_GOOD_CAPTURES:
+      if (mp->index < mp->list.count)
+        return pick_best(mp);
+      mp->stage = mp->captures_only ? STAGE_DONE : STAGE_REFUTATIONS;
+      break;
+
+    case STAGE_REFUTATIONS:
+      // Quiet moves that caused a cutoff elsewhere. Each is handed out at
+      // most once; the ones that are not played here are forgotten so the
+      // quiet stage does not skip them.
+      while (mp->refutation_index < 3) {
+        int i = mp->refutation_index++;
+        move_t move = mp->refutations[i];
+        mp->refutations[i] = MOVE_NONE;
+        if (move != MOVE_NONE && move != mp->tt_move &&
+            !is_refutation(mp, move) && !move_is_capture(mp->pos, move) &&
+            move_flags(move) != MOVE_PROMOTION &&
+            move_is_legal(mp->pos, move)) {
+          mp->refutations[i] = move;
+          return move;
+        }
+      }
+      mp->stage = STAGE_QUIETS_INIT;
+      break;
+
+    case STAGE_QUIETS_INIT:
+      generate_moves(mp->pos, &mp->list, GEN_QUIETS);
+      score_quiets(mp);
+      mp->index = 0;
+      mp->stage = STAGE_QUIETS;
+      break;
+
+    case STAGE_QUIETS:
+      if (mp->index < mp->list.count)
+        return pick_best(mp);
+      mp->stage = STAGE_BAD_CAPTURES;
+      break;
+
+    case STAGE_BAD_CAPTURES:
+      if (mp->bad_index < mp->bad_captures.count)
+        return mp->bad_captures.moves[mp->bad_index++];
+      mp->stage = STAGE_DONE;
+      break;
+
+    default:
+      return MOVE_NONE;
+    }
+  }
+}
+
+int see_ge(const position_t *pos, move_t move, int threshold) {
+  // Castling and en passant are not worth the special cases
+  int flags = move_flags(move);
+  if (flags == MOVE_CASTLING || flags == MOVE_EN_PASSANT)
+    return threshold <= 0;
+
+  const board_t *board = &pos->board;
+  int from = move_from(move);
+  int to = move_to(move);
+
+  // swap is what the side to move stands to gain if the exchange stops now,
+  // relative to threshold. A promotion also gains the new piece for the
+  // pawn, and puts the new piece at risk.
+  int moved = type_of(piece_on(board, from));
+  int swap = piece_value[type_of(piece_on(board, to))] - threshold;
+  if (flags == MOVE_PROMOTION) {
+    moved = move_promotion(move);
+    swap += piece_value[moved] - piece_value[PAWN];
+  }
+  if (swap < 0)
+    return 0;
+  swap = piece_value[moved] - swap;
+  if (swap <= 0)
+    return 1;
+
+  bitboard_t occupied = board->occupied[NONE] ^ square_bb(from) ^ square_bb(to);
+  bitboard_t attackers = attackers_to(board, to, occupied);
+  bitboard_t diagonal = 0, straight = 0;
+  for (int color = WHITE; color <= BLACK; color++) {
+    diagonal |= board->pieces[color][BISHOP] | board->pieces[color][QUEEN];
+    straight |= board->pieces[color][ROOK] | board->pieces[color][QUEEN];
+  }
+
+  int stm = pos->side_to_move;
+  int result = 1;
+
+  for (;;) {
+    stm = opponent_of(stm);
+    attackers &= occupied;
+    bitboard_t ours = attackers & board->occupied[stm];
+    if (!ours)
+      break;
+
+    result ^= 1;
+
+    // Recapture with the least valuable piece; removing a pawn, bishop, rook
+    // or queen can uncover a slider behind it
+    const bitboard_t *pieces = board->pieces[stm];
+    bitboard_t bb;
+    if ((bb = ours & pieces[PAWN])) {
+      if ((swap = piece_value[PAWN] - swap) < result)
+        break;
+      occupied ^= bb & -bb;
+      attackers |= bishop_attacks(to, occupied) & diagonal;
+    } else if ((bb = ours & pieces[KNIGHT])) {
+      if ((swap = piece_value[KNIGHT] - swap) < result)
+        break;
+      occupied ^= bb & -bb;
+    } else if ((bb = ours & pieces[BISHOP])) {
+      if ((swap = piece_value[BISHOP] - swap) < result)
+        break;
+      occupied ^= bb & -bb;
+      attackers |= bishop_attacks(to, occupied) & diagonal;
+    } else if ((bb = ours & pieces[ROOK])) {
+      if ((swap = piece_value[ROOK] - swap) < result)
+        break;
+      occupied ^= bb & -bb;
+      attackers |= rook_attacks(to, occupied) & straight;
+    } else if ((bb = ours & pieces[QUEEN])) {
+      if ((swap = piece_value[QUEEN] - swap) < result)
+        break;
+      occupied ^= bb & -bb;
+      attackers |= (bishop_attacks(to, occupied) & diagonal) |
+                   (rook_attacks(to, occupied) & straight);
+    } else {
+      // Only the king is left: it may take only if nothing recaptures
+      return (attackers & ~board->occupied[stm]) ? result ^ 1 : result;
+    }
+  }
+
+  return result;
+}
+
+void history_clear(history_t *history) {
+  memset(history, 0, sizeof(*history));
+}
+
+// Move a history score towards +-HISTORY_MAX by bonus. Scores near the limit
+// move less, so recent results keep mattering.
+static void apply_bonus(int *entry, int bonus) {
+  int magnitude = (bonus < 0) ? -bonus : bonus;
+  *entry += bonus - *entry * magnitude / HISTORY_MAX;
+}
+
+void history_update(history_t *history, const position_t *pos, move_t best,
+                    const move_t *quiets, int quiet_count, int depth) {
+  int us = pos->side_to_move;
+  int bonus = depth * depth;
+  if (bonus > HISTORY_MAX / 4)
+    bonus = HISTORY_MAX / 4;
+
+  apply_bonus(&history->butterfly[us][move_from(best)][move_to(best)], bonus);
+  for (int i = 0; i < quiet_count; i++) {
+    move_t move = quiets[i];
+    if (move != best)
+      apply_bonus(&history->butterfly[us][move_from(move)][move_to(move)],
+                  -bonus);
+  }
+
+  if (pos->ply > 0 && pos->history[pos->ply - 1].move != MOVE_NONE) {
+    int to = move_to(pos->history[pos->ply - 1].move);
+    piece_t moved = piece_on(&pos->board, to);
+    history->countermoves[color_of(moved)][type_of(moved)][to] = best;
+  }
+}
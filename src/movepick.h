@@ -0,0 +1,81 @@
+#ifndef MOVEPICK_H
+#define MOVEPICK_H
+
+#include "move.h"
+#include "position.h"
+
+// Stages of a move picker, in the order moves are handed out
+enum {
+  STAGE_TT_MOVE,
+  STAGE_CAPTURES_INIT,
+  STAGE_GOOD_CAPTURES,
+  STAGE_REFUTATIONS,
+  STAGE_QUIETS_INIT,
+  STAGE_QUIETS,
+  STAGE_BAD_CAPTURES,
+  STAGE_DONE
+};
+
+// History scores stay within +-HISTORY_MAX
+#define HISTORY_MAX 16384
+
+// What a search thread has learned about quiet moves from beta cutoffs
+typedef struct {
+  // Butterfly table: how often a quiet move from one square to another
+  // caused a cutoff, [color][from][to]
+  int butterfly[COLOR_COUNT][SQUARE_COUNT][SQUARE_COUNT];
+  // Quiet move that refuted the previous move, indexed by the color, type
+  // and target square of that previous move
+  move_t countermoves[COLOR_COUNT][PIECE_TYPE_COUNT][SQUARE_COUNT];
+} history_t;
+
+// Hands out the legal moves of a position one at a time: the table move,
+// captures that win material (most valuable victim first, least valuable
+// attacker next), the refutations (two killer moves and the countermove),
+// the remaining quiet moves by history score and finally captures that lose
+// material. Each group is only generated when the previous one is used up,
+// so a node that cuts off early never pays for the quiet moves.
+typedef struct {
+  const position_t *pos;
+  const history_t *history;
+  int captures_only; // Quiescence: stop after the good captures
+  int stage;
+  move_t tt_move;
+  move_t refutations[3]; // Killers, then the countermove
+  int refutation_index;
+  move_list_t list; // Moves of the current stage
+  int scores[MAX_MOVES];
+  int index; // Next unused entry in list
+  move_list_t bad_captures;
+  int bad_index;
+} move_picker_t;
+
+// tt_move and killers may be MOVE_NONE or moves that are not legal here;
+// they are checked before being handed out. killers and history may be NULL.
+void move_picker_init(move_picker_t *mp, const position_t *pos,
+                      move_t tt_move, const move_t *killers,
+                      const history_t *history);
+
+// Picker for the quiescence search: only the table move (if it is a capture
+// or promotion) and the captures that do not lose material
+void move_picker_init_captures(move_picker_t *mp, const position_t *pos,
+                               move_t tt_move);
+
+// The next move to try, or MOVE_NONE once every legal move has been returned.
+// No move is returned twice.
+move_t next_move(move_picker_t *mp);
+
+// Static exchange evaluation: whether move wins at least threshold
+// centipawns once every capture and recapture on its target square has
+// been played out, least valuable attacker first, by either side stopping
+// as soon as continuing would lose material.
+int see_ge(const position_t *pos, move_t move, int threshold);
+
+void history_clear(history_t *history);
+
+// Reward best, a quiet move that caused a beta cutoff at the given depth,
+// and penalize the quiet moves searched before it without success
+void history_update(history_t *history, const position_t *pos, move_t best,
+                    const move_t *quiets, int quiet_count, int depth);
+
+#endif // MOVEPICK_H
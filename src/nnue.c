@@ -0,0 +1,301 @@
+#include "nnue.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Kernels are picked at compile time, like the slider lookups: AVX2 under
+// make native on a recent CPU, SSE4.1 when only that is enabled, and plain C
+// otherwise. All three compute exactly the same integers.
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define USE_AVX2
+#elif defined(__SSE4_1__)
+#include <smmintrin.h>
+#define USE_SSE41
+#endif
+
+// Network file layout, all integers little-endian:
+//   "CHNN", uint32 version, uint32 inputs, uint32 hidden
+//   int16 feature weights [inputs][hidden]
+//   int16 feature biases [hidden]
+//   int8 output weights [2 * hidden], side to move's half first
+//   int32 output bias
+#define NNUE_MAGIC "CHNN"
+#define NNUE_HEADER_SIZE 16
+#define NNUE_FILE_SIZE                                                         \
+  (NNUE_HEADER_SIZE + NNUE_INPUTS * NNUE_HIDDEN * 2 + NNUE_HIDDEN * 2 +        \
+   2 * NNUE_HIDDEN + 4)
+
+// An accumulator more than this many plies from a computed one is rebuilt
+// from the board instead, which costs about as much as this many updates
+#define NNUE_MAX_UPDATE_DISTANCE 8
+
+// Largest score the network can return, well clear of the mate scores
+#define NNUE_MAX_SCORE 20000
+
+static struct {
+  int loaded;
+  _Alignas(32) int16_t feature_weights[NNUE_INPUTS][NNUE_HIDDEN];
+  _Alignas(32) int16_t feature_bias[NNUE_HIDDEN];
+  _Alignas(32) int8_t output_weights[2][NNUE_HIDDEN];
+  int32_t output_bias;
+} g_nnue;
+
+/// Loading
+static uint32_t read_u32(const uint8_t *p) {
+  return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) |
+         ((uint32_t)p[3] << 24);
+}
+
+static int16_t read_i16(const uint8_t *p) {
+  return (int16_t)(uint16_t)(p[0] | (p[1] << 8));
+}
+
+ErrorCode nnue_load(const char *path) {
+  if (!path)
+    return ERROR_INVALID_INPUT;
+
+  FILE *file = fopen(path, "rb");
+  if (!file) {
+    fprintf(stderr, "Unable to open network %s\n", path);
+    return ERROR_FILE_LOAD;
+  }
+
+  uint8_t *data = malloc(NNUE_FILE_SIZE + 1);
+  if (!data) {
+    fclose(file);
+    return ERROR_MEMORY_ALLOC;
+  }
+
+  // Read one byte more than expected so a longer file is caught too
+  size_t size = fread(data, 1, NNUE_FILE_SIZE + 1, file);
+  fclose(file);
+
+  ErrorCode result = ERROR_NONE;
+  if (size < NNUE_HEADER_SIZE || memcmp(data, NNUE_MAGIC, 4) != 0) {
+    fprintf(stderr, "%s is not a network file\n", path);
+    result = ERROR_FILE_LOAD;
+  } else if (read_u32(data + 4) != NNUE_VERSION ||
+             read_u32(data + 8) != NNUE_INPUTS ||
+             read_u32(data + 12) != NNUE_HIDDEN) {
+    fprintf(stderr, "%s: unsupported network version %u (%ux%u)\n", path,
+            read_u32(data + 4), read_u32(data + 8), read_u32(data + 12));
+    result = ERROR_FILE_LOAD;
+  } else if (size != NNUE_FILE_SIZE) {
+    fprintf(stderr, "%s: expected %d bytes\n", path, NNUE_FILE_SIZE);
+    result = ERROR_FILE_LOAD;
+  }
+  if (result != ERROR_NONE) {
+    free(data);
+    return result;
+  }
+
+  const uint8_t *p = data + NNUE_HEADER_SIZE;
+  for (int i = 0; i < NNUE_INPUTS; i++) {
+    for (int j = 0; j < NNUE_HIDDEN; j++, p += 2) {
+      g_nnue.feature_weights[i][j] = read_i16(p);
+    }
+  }
+  for (int j = 0; j < NNUE_HIDDEN; j++, p += 2) {
+    g_nnue.feature_bias[j] = read_i16(p);
+  }
+  for (int side = 0; side < 2; side++) {
+    for (int j = 0; j < NNUE_HIDDEN; j++, p++) {
+      g_nnue.output_weights[side][j] = (int8_t)*p;
+    }
+  }
+  g_nnue.output_bias = (int32_t)read_u32(p);
+  g_nnue.loaded = 1;
+
+  free(data);
+  return ERROR_NONE;
+}
+
+void nnue_unload(void) { g_nnue.loaded = 0; }
+
+int nnue_is_loaded(void) { return g_nnue.loaded; }
+
+/// Accumulator updates
+// Input of a piece on a square as seen by perspective
+static inline int feature_index(int perspective, piece_t piece, int square) {
+  int relative = (color_of(piece) == perspective) ? 0 : 1;
+  int oriented = (perspective == WHITE) ? (square ^ 56) : square;
+  return ((relative * 6 + type_of(piece) - 1) << 6) + oriented;
+}
+
+// out = in + the added columns - the removed ones. out may equal in.
+static void update_values(int16_t *out, const int16_t *in,
+                          const int16_t *const *added, int added_count,
+                          const int16_t *const *removed, int removed_count) {
+#if defined(USE_AVX2)
+  for (int j = 0; j < NNUE_HIDDEN; j += 16) {
+    __m256i v = _mm256_loadu_si256((const __m256i *)(in + j));
+    for (int k = 0; k < added_count; k++) {
+      v = _mm256_add_epi16(
+          v, _mm256_load_si256((const __m256i *)(added[k] + j)));
+    }
+    for (int k = 0; k < removed_count; k++) {
+      v = _mm256_sub_epi16(
+          v, _mm256_load_si256((const __m256i *)(removed[k] + j)));
+    }
+    _mm256_storeu_si256((__m256i *)(out + j), v);
+  }
+#elif defined(USE_SSE41)
+  for (int j = 0; j < NNUE_HIDDEN; j += 8) {
+    __m128i v = _mm_loadu_si128((const __m128i *)(in + j));
+    for (int k = 0; k < added_count; k++) {
+      v = _mm_add_epi16(v, _mm_load_si128((const __m128i *)(added[k] + j)));
+    }
+    for (int k = 0; k < removed_count; k++) {
+      v = _mm_sub_epi16(v, _mm_load_si128((const __m128i *)(removed[k] + j)));
+    }
+    _mm_storeu_si128((__m128i *)(out + j), v);
+  }
+#else
+  for (int j = 0; j < NNUE_HIDDEN; j++) {
+    int v = in[j];
+    for (int k = 0; k < added_count; k++) {
+      v += added[k][j];
+    }
+    for (int k = 0; k < removed_count; k++) {
+      v -= removed[k][j];
+    }
+    out[j] = (int16_t)v;
+  }
+#endif
+}
+
+// Build an accumulator from scratch from the pieces on board
+static void refresh(nnue_accumulator_t *entry, const board_t *board) {
+  for (int perspective = WHITE; perspective <= BLACK; perspective++) {
+    int16_t *values = entry->values[perspective - WHITE];
+    memcpy(values, g_nnue.feature_bias, sizeof(g_nnue.feature_bias));
+
+    bitboard_t occupied = board->occupied[NONE];
+    while (occupied) {
+      int square = pop_lsb(&occupied);
+      const int16_t *column = g_nnue.feature_weights[feature_index(
+          perspective, board->squares[square], square)];
+      update_values(values, values, &column, 1, NULL, 0);
+    }
+  }
+  entry->computed = 1;
+}
+
+// Bring entry up to date from the one before it
+static void apply_move(nnue_accumulator_t *entry,
+                       const nnue_accumulator_t *previous) {
+  for (int perspective = WHITE; perspective <= BLACK; perspective++) {
+    const int16_t *added[2];
+    const int16_t *removed[2];
+    for (int k = 0; k < entry->added_count; k++) {
+      added[k] = g_nnue.feature_weights[feature_index(
+          perspective, entry->added_piece[k], entry->added_square[k])];
+    }
+    for (int k = 0; k < entry->removed_count; k++) {
+      removed[k] = g_nnue.feature_weights[feature_index(
+          perspective, entry->removed_piece[k], entry->removed_square[k])];
+    }
+    update_values(entry->values[perspective - WHITE],
+                  previous->values[perspective - WHITE], added,
+                  entry->added_count, removed, entry->removed_count);
+  }
+  entry->computed = 1;
+}
+
+void nnue_reset(nnue_stack_t *stack) {
+  stack->top = 0;
+  stack->entries[0].computed = 0;
+  stack->entries[0].added_count = 0;
+  stack->entries[0].removed_count = 0;
+}
+
+/// Output layer
+// Dot product of one half of the hidden layer, clipped to [0, NNUE_QA],
+// with its output weights
+static int32_t output_half(const int16_t *values, const int8_t *weights) {
+#if defined(USE_AVX2)
+  const __m256i zero = _mm256_setzero_si256();
+  const __m256i max = _mm256_set1_epi16(NNUE_QA);
+  const __m256i ones = _mm256_set1_epi16(1);
+  __m256i sum = _mm256_setzero_si256();
+  for (int j = 0; j < NNUE_HIDDEN; j += 32) {
+    __m256i a = _mm256_loadu_si256((const __m256i *)(values + j));
+    __m256i b = _mm256_loadu_si256((const __m256i *)(values + j + 16));
+    a = _mm256_min_epi16(_mm256_max_epi16(a, zero), max);
+    b = _mm256_min_epi16(_mm256_max_epi16(b, zero), max);
+    // packus interleaves the 128-bit lanes; put them back in order
+    __m256i clipped =
+        _mm256_permute4x64_epi64(_mm256_packus_epi16(a, b), 0xD8);
+    __m256i products = _mm256_maddubs_epi16(
+        clipped, _mm256_load_si256((const __m256i *)(weights + j)));
+    sum = _mm256_add_epi32(sum, _mm256_madd_epi16(products, ones));
+  }
+  __m128i half = _mm_add_epi32(_mm256_castsi256_si128(sum),
+                               _mm256_extracti128_si256(sum, 1));
+  half = _mm_add_epi32(half, _mm_shuffle_epi32(half, 0x4E));
+  half = _mm_add_epi32(half, _mm_shuffle_epi32(half, 0xB1));
+  return _mm_cvtsi128_si32(half);
+#elif defined(USE_SSE41)
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i max = _mm_set1_epi16(NNUE_QA);
+  const __m128i ones = _mm_set1_epi16(1);
+  __m128i sum = _mm_setzero_si128();
+  for (int j = 0; j < NNUE_HIDDEN; j += 16) {
+    __m128i a = _mm_loadu_si128((const __m128i *)(values + j));
+    __m128i b = _mm_loadu_si128((const __m128i *)(values + j + 8));
+    a = _mm_min_epi16(_mm_max_epi16(a, zero), max);
+    b = _mm_min_epi16(_mm_max_epi16(b, zero), max);
+    __m128i products = _mm_maddubs_epi16(
+        _mm_packus_epi16(a, b), _mm_load_si128((const __m128i *)(weights + j)));
+    sum = _mm_add_epi32(sum, _mm_madd_epi16(products, ones));
+  }
+  sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0x4E));
+  sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0xB1));
+  return _mm_cvtsi128_si32(sum);
+#else
+  int32_t sum = 0;
+  for (int j = 0; j < NNUE_HIDDEN; j++) {
+    int v = values[j];
+    v = v < 0 ? 0 : (v > NNUE_QA ? NNUE_QA : v);
+    sum += v * weights[j];
+  }
+  return sum;
+#endif
+}
+
+int nnue_evaluate(const position_t *pos) {
+  nnue_stack_t *stack = pos->nnue;
+  nnue_accumulator_t *entries = stack->entries;
+  int top = stack->top;
+
+  // Walk back to the nearest computed accumulator and replay the moves
+  // from there, or start over from the board if it is too far
+  int base = top;
+  while (base >= 0 && !entries[base].computed &&
+         top - base < NNUE_MAX_UPDATE_DISTANCE) {
+    base--;
+  }
+  if (base < 0 || !entries[base].computed) {
+    refresh(&entries[top], &pos->board);
+  } else {
+    for (int i = base + 1; i <= top; i++) {
+      apply_move(&entries[i], &entries[i - 1]);
+    }
+  }
+
+  int us = pos->side_to_move;
+  const nnue_accumulator_t *entry = &entries[top];
+  int32_t output =
+      g_nnue.output_bias +
+      output_half(entry->values[us - WHITE], g_nnue.output_weights[0]) +
+      output_half(entry->values[opponent_of(us) - WHITE],
+                  g_nnue.output_weights[1]);
+
+  int score = (int)((int64_t)output * NNUE_SCALE / (NNUE_QA * NNUE_QB));
+  if (score > NNUE_MAX_SCORE)
+    score = NNUE_MAX_SCORE;
+  if (score < -NNUE_MAX_SCORE)
+    score = -NNUE_MAX_SCORE;
+  return score;
+}
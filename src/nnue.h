@@ -0,0 +1,91 @@
+#ifndef NNUE_H
+#define NNUE_H
+
+#include "config.h"
+#include "position.h"
+#include <stdint.h>
+
+// Efficiently updatable neural network evaluation. The network is
+//   768 inputs -> 2 x NNUE_HIDDEN (one half per side) -> 1 output
+// The inputs are one per piece type, color and square, seen from each side:
+// own pieces first, squares numbered from that side's back rank. The
+// hidden layer (the accumulator) is a sum of weight columns, one per piece
+// on the board, so a move only adds and subtracts the few columns of the
+// pieces it touches.
+#define NNUE_VERSION 1
+#define NNUE_INPUTS 768
+#define NNUE_HIDDEN 256
+
+// Quantisation: hidden activations are clipped to [0, NNUE_QA] and output
+// weights are scaled by NNUE_QB; the raw output times
+// NNUE_SCALE / (NNUE_QA * NNUE_QB) is in centipawns
+#define NNUE_QA 127
+#define NNUE_QB 64
+#define NNUE_SCALE 400
+
+// Accumulators for one line of play, one per ply. make_move only notes
+// which pieces changed; the columns are applied when a position is
+// evaluated, so nodes that are never evaluated cost nothing.
+#define NNUE_STACK_SIZE 160
+
+typedef struct {
+  int16_t values[2][NNUE_HIDDEN]; // [color - WHITE]
+  int computed;
+  // Pieces the move into this ply took away and put down
+  int removed_count;
+  int added_count;
+  piece_t removed_piece[2];
+  piece_t added_piece[2];
+  uint8_t removed_square[2];
+  uint8_t added_square[2];
+} nnue_accumulator_t;
+
+typedef struct nnue_stack {
+  nnue_accumulator_t entries[NNUE_STACK_SIZE];
+  int top; // May run past the end; such plies are evaluated without it
+} nnue_stack_t;
+
+// Load a network file, replacing any loaded before. Not safe while a search
+// is running.
+ErrorCode nnue_load(const char *path);
+void nnue_unload(void);
+int nnue_is_loaded(void);
+
+// Start a new line at the position the stack is attached to
+void nnue_reset(nnue_stack_t *stack);
+
+// Evaluation in centipawns from the side to move's point of view. pos must
+// have a stack attached and within its capacity.
+int nnue_evaluate(const position_t *pos);
+
+// Bookkeeping for make/unmake_move
+static inline void nnue_push(nnue_stack_t *stack) {
+  if (++stack->top < NNUE_STACK_SIZE) {
+    nnue_accumulator_t *entry = &stack->entries[stack->top];
+    entry->computed = 0;
+    entry->removed_count = 0;
+    entry->added_count = 0;
+  }
+}
+
+static inline void nnue_pop(nnue_stack_t *stack) { stack->top--; }
+
+static inline void nnue_remove_piece(nnue_stack_t *stack, piece_t piece,
+                                     int square) {
+  if (stack->top < NNUE_STACK_SIZE) {
+    nnue_accumulator_t *entry = &stack->entries[stack->top];
+    entry->removed_piece[entry->removed_count] = piece;
+    entry->removed_square[entry->removed_count++] = (uint8_t)square;
+  }
+}
+
+static inline void nnue_add_piece(nnue_stack_t *stack, piece_t piece,
+                                  int square) {
+  if (stack->top < NNUE_STACK_SIZE) {
+    nnue_accumulator_t *entry = &stack->entries[stack->top];
+    entry->added_piece[entry->added_count] = piece;
+    entry->added_square[entry->added_count++] = (uint8_t)square;
+  }
+}
+
+#endif // NNUE_H
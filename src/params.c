@@ -0,0 +1,126 @@
+#include "params.h"
+#include "pawns.h"
+#include "psqt.h"
+#include <stdio.h>
+#include <string.h>
+
+static const char *piece_names[PIECE_TYPE_COUNT] = {
+    "", "pawn", "knight", "rook", "bishop", "queen", "king"};
+
+int *param_value(int term, int phase) {
+  if (term < 0 || term >= PARAM_COUNT ||
+      (phase != PHASE_MG && phase != PHASE_EG))
+    return NULL;
+
+  if (term < PARAM_SQUARE_BONUS)
+    return &psqt_piece_value[phase][PAWN + term - PARAM_PIECE_VALUE];
+  if (term < PARAM_PAWN_DOUBLED) {
+    int index = term - PARAM_SQUARE_BONUS;
+    return &psqt_square_bonus[phase][PAWN + index / SQUARE_COUNT]
+                             [index % SQUARE_COUNT];
+  }
+  if (term == PARAM_PAWN_DOUBLED)
+    return &pawn_doubled[phase];
+  if (term == PARAM_PAWN_ISOLATED)
+    return &pawn_isolated[phase];
+  if (term == PARAM_PAWN_BACKWARD)
+    return &pawn_backward[phase];
+  if (term < PARAM_PAWN_SHELTER)
+    return &pawn_passed[phase][1 + term - PARAM_PAWN_PASSED];
+  // The shelter only counts in the middlegame
+  return (phase == PHASE_MG) ? &pawn_shelter[term - PARAM_PAWN_SHELTER]
+                             : NULL;
+}
+
+void param_name(int term, char *out, size_t size) {
+  if (term < PARAM_SQUARE_BONUS) {
+    snprintf(out, size, "value.%s",
+             piece_names[PAWN + term - PARAM_PIECE_VALUE]);
+  } else if (term < PARAM_PAWN_DOUBLED) {
+    int index = term - PARAM_SQUARE_BONUS;
+    int square = index % SQUARE_COUNT;
+    snprintf(out, size, "square.%s.%c%c",
+             piece_names[PAWN + index / SQUARE_COUNT],
+             'a' + square_col(square), '8' - square_row(square));
+  } else if (term == PARAM_PAWN_DOUBLED) {
+    snprintf(out, size, "pawn.doubled");
+  } else if (term == PARAM_PAWN_ISOLATED) {
+    snprintf(out, size, "pawn.isolated");
+  } else if (term == PARAM_PAWN_BACKWARD) {
+    snprintf(out, size, "pawn.backward");
+  } else if (term < PARAM_PAWN_SHELTER) {
+    // Named by the rank as players count it, 2 to 7
+    snprintf(out, size, "pawn.passed.%d", 2 + term - PARAM_PAWN_PASSED);
+  } else {
+    snprintf(out, size, "pawn.shelter.%d", 1 + term - PARAM_PAWN_SHELTER);
+  }
+}
+
+static int find_term(const char *name) {
+  char buffer[32];
+  for (int term = 0; term < PARAM_COUNT; term++) {
+    param_name(term, buffer, sizeof(buffer));
+    if (strcmp(buffer, name) == 0)
+      return term;
+  }
+  return -1;
+}
+
+ErrorCode params_load(const char *path) {
+  FILE *file = fopen(path, "r");
+  if (!file) {
+    fprintf(stderr, "Unable to open parameters %s\n", path);
+    return ERROR_FILE_LOAD;
+  }
+
+  char line[128];
+  int line_number = 0;
+  ErrorCode result = ERROR_NONE;
+  while (fgets(line, sizeof(line), file)) {
+    line_number++;
+    char name[32];
+    int values[2];
+    if (line[0] == '#' || line[0] == '\n' || line[0] == '\r')
+      continue;
+    int term = -1;
+    if (sscanf(line, "%31s %d %d", name, &values[0], &values[1]) == 3)
+      term = find_term(name);
+    if (term < 0) {
+      fprintf(stderr, "%s:%d: invalid parameter line\n", path, line_number);
+      result = ERROR_INVALID_INPUT;
+      break;
+    }
+    for (int phase = PHASE_MG; phase <= PHASE_EG; phase++) {
+      int *value = param_value(term, phase);
+      if (value)
+        *value = values[phase];
+    }
+  }
+  fclose(file);
+
+  psqt_rebuild();
+  return result;
+}
+
+ErrorCode params_save(const char *path) {
+  FILE *file = fopen(path, "w");
+  if (!file) {
+    fprintf(stderr, "Unable to write parameters %s\n", path);
+    return ERROR_FILE_LOAD;
+  }
+
+  fprintf(file, "# Evaluation parameters: name, middlegame, endgame\n");
+  for (int term = 0; term < PARAM_COUNT; term++) {
+    char name[32];
+    param_name(term, name, sizeof(name));
+    int *mg = param_value(term, PHASE_MG);
+    int *eg = param_value(term, PHASE_EG);
+    fprintf(file, "%s %d %d\n", name, mg ? *mg : 0, eg ? *eg : 0);
+  }
+
+  if (fclose(file) != 0) {
+    fprintf(stderr, "Unable to write parameters %s\n", path);
+    return ERROR_FILE_LOAD;
+  }
+  return ERROR_NONE;
+}
@@ -0,0 +1,36 @@
+#ifndef PARAMS_H
+#define PARAMS_H
+
+#include "config.h"
+#include <stddef.h>
+
+// Every tunable weight of the hand-crafted evaluation as a numbered term
+// with a middlegame and an endgame value, so tools can read and write them
+// without knowing which table each lives in
+enum {
+  PARAM_PIECE_VALUE = 0, // + type - PAWN, the king has none
+  PARAM_SQUARE_BONUS = PARAM_PIECE_VALUE + 5, // + (type - PAWN) * 64 + square
+  PARAM_PAWN_DOUBLED = PARAM_SQUARE_BONUS + 6 * 64,
+  PARAM_PAWN_ISOLATED,
+  PARAM_PAWN_BACKWARD,
+  PARAM_PAWN_PASSED, // + rank - 1, for the ranks 1 to 6 a passer can be on
+  PARAM_PAWN_SHELTER = PARAM_PAWN_PASSED + 6, // + distance - 1
+  PARAM_COUNT = PARAM_PAWN_SHELTER + 2
+};
+
+// Where the value of term for phase (PHASE_*) is kept, or NULL if the term
+// has none in that phase
+int *param_value(int term, int phase);
+
+// Name of term in parameter files, such as "square.knight.e4"
+void param_name(int term, char *out, size_t size);
+
+// Parameter files are text, one term per line: its name, then its
+// middlegame and endgame values. Blank lines and lines starting with # are
+// skipped. Loading rebuilds the piece-square tables; terms the file does not
+// mention keep their values, and boards set up earlier keep their old
+// totals.
+ErrorCode params_load(const char *path);
+ErrorCode params_save(const char *path);
+
+#endif // PARAMS_H
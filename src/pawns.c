@@ -0,0 +1,160 @@
+#include "pawns.h"
+#include "psqt.h"
+#include <string.h>
+
+int pawn_doubled[2] = {-10, -25};
+int pawn_isolated[2] = {-8, -14};
+int pawn_backward[2] = {-8, -10};
+int pawn_passed[2][8] = {
+    {0, 0, 5, 10, 25, 45, 75, 0},
+    {0, 10, 15, 30, 55, 90, 140, 0},
+};
+int pawn_shelter[2] = {12, 6};
+
+/// Pawn geometry. White moves toward row 0, the low bits.
+static inline bitboard_t forward(bitboard_t bb, int color) {
+  return (color == WHITE) ? bb >> 8 : bb << 8;
+}
+
+// Every square in front of the squares in bb, those excluded
+static inline bitboard_t front_span(bitboard_t bb, int color) {
+  bb = forward(bb, color);
+  if (color == WHITE) {
+    bb |= bb >> 8;
+    bb |= bb >> 16;
+    bb |= bb >> 32;
+  } else {
+    bb |= bb << 8;
+    bb |= bb << 16;
+    bb |= bb << 32;
+  }
+  return bb;
+}
+
+static inline bitboard_t adjacent_cols(bitboard_t bb) {
+  return ((bb & ~COL_H) << 1) | ((bb & ~COL_A) >> 1);
+}
+
+static inline bitboard_t pawns_attacks(bitboard_t pawns, int color) {
+  return adjacent_cols(forward(pawns, color));
+}
+
+/// Evaluation
+static void count_structure(const board_t *board, int color,
+                            pawn_terms_t *terms) {
+  int them = opponent_of(color);
+  bitboard_t ours = board->pieces[color][PAWN];
+  bitboard_t theirs = board->pieces[them][PAWN];
+  bitboard_t their_attacks = pawns_attacks(theirs, them);
+
+  bitboard_t pawns = ours;
+  while (pawns) {
+    int square = pop_lsb(&pawns);
+    bitboard_t bb = square_bb(square);
+    bitboard_t ahead = front_span(bb, color);
+    bitboard_t neighbours = adjacent_cols(COL_A << square_col(square)) & ours;
+    int rank = (color == WHITE) ? 7 - square_row(square) : square_row(square);
+
+    if (ahead & ours) {
+      terms->doubled++;
+    } else if (!((ahead | adjacent_cols(ahead)) & theirs)) {
+      terms->passed[rank]++;
+    }
+    if (!neighbours) {
+      terms->isolated++;
+    } else if (!(neighbours & ~front_span(adjacent_cols(bb), color)) &&
+               (forward(bb, color) & their_attacks)) {
+      // Every neighbour has already gone past, and the square in front is
+      // held by an enemy pawn
+      terms->backward++;
+    }
+  }
+}
+
+static void count_shelter(const board_t *board, int color,
+                          pawn_terms_t *terms) {
+  bitboard_t king = board->pieces[color][KING];
+  if (!king)
+    return;
+  bitboard_t ours = board->pieces[color][PAWN];
+  bitboard_t front = forward(king | adjacent_cols(king), color);
+  terms->shelter[0] = popcount(ours & front);
+  terms->shelter[1] = popcount(ours & forward(front, color));
+}
+
+void pawns_count_terms(const board_t *board, int color, pawn_terms_t *terms) {
+  memset(terms, 0, sizeof(*terms));
+  count_structure(board, color, terms);
+  count_shelter(board, color, terms);
+}
+
+static int structure_score(const pawn_terms_t *terms, int phase) {
+  int score = terms->doubled * pawn_doubled[phase] +
+              terms->isolated * pawn_isolated[phase] +
+              terms->backward * pawn_backward[phase];
+  for (int rank = 1; rank < 7; rank++) {
+    score += terms->passed[rank] * pawn_passed[phase][rank];
+  }
+  return score;
+}
+
+// Middlegame bonus for the pawns in front of color's king, with sign
+static int evaluate_shelter(const board_t *board, int color, int sign) {
+  pawn_terms_t terms;
+  memset(&terms, 0, sizeof(terms));
+  count_shelter(board, color, &terms);
+  return sign * (terms.shelter[0] * pawn_shelter[0] +
+                 terms.shelter[1] * pawn_shelter[1]);
+}
+
+static void evaluate_structure(const board_t *board, pawn_entry_t *entry) {
+  pawn_terms_t white, black;
+  memset(&white, 0, sizeof(white));
+  memset(&black, 0, sizeof(black));
+  count_structure(board, WHITE, &white);
+  count_structure(board, BLACK, &black);
+  for (int phase = PHASE_MG; phase <= PHASE_EG; phase++) {
+    entry->score[phase] = (int16_t)(structure_score(&white, phase) -
+                                    structure_score(&black, phase));
+  }
+  entry->king_square[0] = SQUARE_NONE;
+  entry->king_square[1] = SQUARE_NONE;
+}
+
+void pawn_table_clear(pawn_table_t *table) {
+  memset(table, 0, sizeof(*table));
+}
+
+void pawns_evaluate(const position_t *pos, int *mg, int *eg) {
+  const board_t *board = &pos->board;
+  pawn_table_t *table = pos->pawn_table;
+  pawn_entry_t scratch;
+  pawn_entry_t *entry = &scratch;
+
+  if (table) {
+    entry = &table->entries[pos->pawn_key & (PAWN_TABLE_SIZE - 1)];
+    table->probes++;
+  }
+  if (table && entry->key == pos->pawn_key) {
+    table->hits++;
+  } else {
+    entry->key = pos->pawn_key;
+    evaluate_structure(board, entry);
+  }
+
+  int shelter = 0;
+  for (int color = WHITE; color <= BLACK; color++) {
+    int index = color - WHITE;
+    bitboard_t king = board->pieces[color][KING];
+    int square = king ? lsb(king) : SQUARE_NONE;
+    if (entry->king_square[index] != square) {
+      entry->king_square[index] = (int8_t)square;
+      entry->shelter[index] = (int16_t)evaluate_shelter(
+          board, color, (color == WHITE) ? 1 : -1);
+    }
+    shelter += entry->shelter[index];
+  }
+
+  *mg = entry->score[PHASE_MG] + shelter;
+  *eg = entry->score[PHASE_EG];
+}
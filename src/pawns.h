@@ -0,0 +1,55 @@
+#ifndef PAWNS_H
+#define PAWNS_H
+
+#include "position.h"
+#include <stdint.h>
+
+// Pawn structure evaluation: doubled, isolated, backward and passed pawns,
+// and the pawns sheltering each king. The structure only depends on where
+// the pawns stand, which few moves change, so it is cached by
+// pos->pawn_key. Each entry also remembers the shelter of the last king
+// squares it was asked about, as kings move rarely too.
+#define PAWN_TABLE_SIZE 16384 // Entries, a power of two
+
+// Weights as {middlegame, endgame}. Changing them invalidates the tables.
+extern int pawn_doubled[2];     // Per pawn with another of its own ahead
+extern int pawn_isolated[2];    // No friendly pawns on the columns next to it
+extern int pawn_backward[2];    // Neighbours all ahead, stop square attacked
+extern int pawn_passed[2][8];   // By rank, from the pawn's own back rank
+// Middlegame only, per own pawn one and two ranks in front of the king, on
+// its column or the columns next to it: in the endgame the king wants out
+extern int pawn_shelter[2];
+
+typedef struct {
+  uint64_t key;
+  int16_t score[2];       // [PHASE_*], from White's point of view
+  int16_t shelter[2];     // Middlegame, [color - WHITE], White's view
+  int8_t king_square[2];  // Where shelter was computed for
+} pawn_entry_t;
+
+// One per search thread, so probes need no synchronisation
+typedef struct pawn_table {
+  pawn_entry_t entries[PAWN_TABLE_SIZE];
+  uint64_t probes;
+  uint64_t hits;
+} pawn_table_t;
+
+// How many pawns each term applies to for one side, the weights aside
+typedef struct {
+  int doubled;
+  int isolated;
+  int backward;
+  int passed[8]; // By rank
+  int shelter[2];
+} pawn_terms_t;
+
+void pawn_table_clear(pawn_table_t *table);
+
+// Count color's terms. Only the pawn and king bitboards of board are read.
+void pawns_count_terms(const board_t *board, int color, pawn_terms_t *terms);
+
+// Middlegame and endgame pawn structure scores of pos from White's point of
+// view, through the table attached to pos if there is one
+void pawns_evaluate(const position_t *pos, int *mg, int *eg);
+
+#endif // PAWNS_H
@@ -0,0 +1,194 @@
+// clock_gettime is POSIX, hidden by -std=c11
+#define _POSIX_C_SOURCE 199309L
+#include "perft.h"
+#include "movegen.h"
+#include "timer.h"
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// Cached subtree count. Threads share the table without locks: key_xor holds
+// the position key XORed with data, so an entry torn by a concurrent write no
+// longer matches its key and is simply treated as a miss.
+typedef struct {
+  _Atomic uint64_t key_xor;
+  _Atomic uint64_t data; // Node count << 8 | depth
+} perft_entry_t;
+
+typedef struct {
+  perft_entry_t *entries;
+  uint64_t mask; // Entry count - 1, the count is a power of two
+} perft_table_t;
+
+// Work shared by the threads of one perft_run
+typedef struct {
+  const position_t *root;
+  move_list_t moves;
+  uint64_t counts[MAX_MOVES];
+  atomic_int next_move; // Index of the next root move to hand out
+  int depth;
+  perft_table_t *table;
+} perft_job_t;
+
+static int table_init(perft_table_t *table, int hash_mb) {
+  uint64_t count = 1;
+  uint64_t bytes = (uint64_t)hash_mb << 20;
+  while (count * 2 * sizeof(perft_entry_t) <= bytes)
+    count *= 2;
+
+  table->entries = calloc(count, sizeof(perft_entry_t));
+  if (!table->entries)
+    return 0;
+  table->mask = count - 1;
+  return 1;
+}
+
+static int table_probe(const perft_table_t *table, uint64_t key, int depth,
+                       uint64_t *nodes) {
+  perft_entry_t *entry = &table->entries[key & table->mask];
+  uint64_t data = atomic_load_explicit(&entry->data, memory_order_relaxed);
+  uint64_t key_xor =
+      atomic_load_explicit(&entry->key_xor, memory_order_relaxed);
+
+  if ((key_xor ^ data) != key || (int)(data & 0xff) != depth)
+    return 0;
+  *nodes = data >> 8;
+  return 1;
+}
+
+static void table_store(perft_table_t *table, uint64_t key, int depth,
+                        uint64_t nodes) {
+  perft_entry_t *entry = &table->entries[key & table->mask];
+  uint64_t data = (nodes << 8) | (uint64_t)depth;
+  atomic_store_explicit(&entry->key_xor, key ^ data, memory_order_relaxed);
+  atomic_store_explicit(&entry->data, data, memory_order_relaxed);
+}
+
+static uint64_t perft_search(position_t *pos, int depth,
+                             perft_table_t *table) {
+  move_list_t list;
+  int count = generate_legal_moves(pos, &list);
+
+  // Bulk counting: the last ply only needs the number of legal moves
+  if (depth <= 1)
+    return (depth == 1) ? (uint64_t)count : 1;
+
+  uint64_t nodes = 0;
+  if (table && table_probe(table, pos->key, depth, &nodes))
+    return nodes;
+
+  for (int i = 0; i < count; i++) {
+    make_move(pos, list.moves[i]);
+    nodes += perft_search(pos, depth - 1, table);
+    unmake_move(pos);
+  }
+
+  if (table)
+    table_store(table, pos->key, depth, nodes);
+  return nodes;
+}
+
+uint64_t perft(position_t *pos, int depth) {
+  return perft_search(pos, depth, NULL);
+}
+
+static void *perft_worker(void *arg) {
+  perft_job_t *job = arg;
+
+  // Every worker searches its own copy of the root position
+  position_t *pos = malloc(sizeof(position_t));
+  if (!pos)
+    return NULL;
+  *pos = *job->root;
+
+  for (;;) {
+    int i = atomic_fetch_add(&job->next_move, 1);
+    if (i >= job->moves.count)
+      break;
+
+    make_move(pos, job->moves.moves[i]);
+    job->counts[i] = perft_search(pos, job->depth - 1, job->table);
+    unmake_move(pos);
+  }
+
+  free(pos);
+  return NULL;
+}
+
+uint64_t perft_run(const position_t *pos, const perft_options_t *options) {
+  perft_job_t *job = calloc(1, sizeof(perft_job_t));
+  if (!job) {
+    fprintf(stderr, "Out of memory\n");
+    return 0;
+  }
+
+  int64_t start = time_now_ms();
+  uint64_t total = 0;
+
+  perft_table_t table = {NULL, 0};
+  if (options->hash_mb > 0 && options->depth > 2) {
+    if (!table_init(&table, options->hash_mb)) {
+      fprintf(stderr, "Could not allocate %d MB perft hash, running without\n",
+              options->hash_mb);
+    }
+  }
+
+  job->root = pos;
+  job->depth = options->depth;
+  job->table = table.entries ? &table : NULL;
+  atomic_init(&job->next_move, 0);
+  generate_legal_moves(pos, &job->moves);
+
+  if (options->depth <= 0) {
+    total = 1;
+  } else if (options->depth == 1) {
+    for (int i = 0; i < job->moves.count; i++)
+      job->counts[i] = 1;
+  } else {
+    int threads = options->threads;
+    if (threads < 1)
+      threads = 1;
+    if (threads > PERFT_MAX_THREADS)
+      threads = PERFT_MAX_THREADS;
+
+    // The calling thread works too, so only threads - 1 are started
+    pthread_t workers[PERFT_MAX_THREADS];
+    int started = 0;
+    for (int i = 1; i < threads; i++) {
+      if (pthread_create(&workers[started], NULL, perft_worker, job) != 0) {
+        fprintf(stderr, "Could not start perft thread %d\n", i);
+        break;
+      }
+      started++;
+    }
+
+    perft_worker(job);
+    for (int i = 0; i < started; i++)
+      pthread_join(workers[i], NULL);
+  }
+
+  for (int i = 0; i < job->moves.count; i++) {
+    total += job->counts[i];
+    if (options->divide) {
+      char uci[6];
+      move_to_uci(job->moves.moves[i], uci);
+      printf("%s: %" PRIu64 "\n", uci, job->counts[i]);
+    }
+  }
+
+  int64_t elapsed = time_now_ms() - start;
+  // A run under a millisecond counts as one, so NPS stays a rate
+  uint64_t nps = total * 1000 / (uint64_t)(elapsed > 0 ? elapsed : 1);
+
+  if (options->divide)
+    printf("\n");
+  printf("Nodes: %" PRIu64 "\n", total);
+  printf("Time: %" PRId64 " ms\n", elapsed);
+  printf("NPS: %" PRIu64 "\n", nps);
+
+  free(table.entries);
+  free(job);
+  return total;
+}
@@ -0,0 +1,25 @@
+#ifndef PERFT_H
+#define PERFT_H
+
+#include "position.h"
+#include <stdint.h>
+
+#define PERFT_MAX_THREADS 64
+
+typedef struct {
+  int depth;
+  int divide;  // Print the node count below each root move
+  int hash_mb; // Size of the subtree cache in megabytes, 0 disables it
+  int threads; // Worker threads the root moves are split across
+} perft_options_t;
+
+// Number of leaf nodes depth plies below pos. Single-threaded and uncached;
+// pos is restored before returning.
+uint64_t perft(position_t *pos, int depth);
+
+// Benchmark driver: splits the root moves over worker threads, optionally
+// caches subtree counts, and prints the divide output, the total and the
+// nodes per second to stdout. Returns the total node count.
+uint64_t perft_run(const position_t *pos, const perft_options_t *options);
+
+#endif // PERFT_H
@@ -0,0 +1,379 @@
+#include "position.h"
+#include "attacks.h"
+#include "nnue.h"
+#include "psqt.h"
+#include "zobrist.h"
+#include <ctype.h>
+#include <stdlib.h>
+
+// Castling rights that survive a move touching each square: moving the king
+// or a rook, or capturing a rook on its home square, drops the matching right
+static const int castling_mask[SQUARE_COUNT] = {
+    7,  15, 15, 15, 3,  15, 15, 11, // Row 0: black rook, king, rook
+    15, 15, 15, 15, 15, 15, 15, 15, //
+    15, 15, 15, 15, 15, 15, 15, 15, //
+    15, 15, 15, 15, 15, 15, 15, 15, //
+    15, 15, 15, 15, 15, 15, 15, 15, //
+    15, 15, 15, 15, 15, 15, 15, 15, //
+    15, 15, 15, 15, 15, 15, 15, 15, //
+    13, 15, 15, 15, 12, 15, 15, 14, // Row 7: white rook, king, rook
+};
+
+void position_clear(position_t *pos) {
+  if (!pos)
+    return;
+
+  init_attacks();
+  init_zobrist();
+  init_psqt();
+
+  clear_board(&pos->board);
+  pos->nnue = NULL;
+  pos->pawn_table = NULL;
+  pos->key = 0;
+  pos->pawn_key = 0;
+  pos->side_to_move = WHITE;
+  pos->castling = 0;
+  pos->ep_square = SQUARE_NONE;
+  pos->halfmove_clock = 0;
+  pos->fullmove_number = 1;
+  pos->ply = 0;
+}
+
+void position_set_start(position_t *pos) { position_set_fen(pos, START_FEN); }
+
+static int piece_type_from_char(char c) {
+  switch (tolower((unsigned char)c)) {
+  case 'p':
+    return PAWN;
+  case 'n':
+    return KNIGHT;
+  case 'b':
+    return BISHOP;
+  case 'r':
+    return ROOK;
+  case 'q':
+    return QUEEN;
+  case 'k':
+    return KING;
+  default:
+    return EMPTY;
+  }
+}
+
+ErrorCode position_set_fen(position_t *pos, const char *fen) {
+  if (!pos || !fen)
+    return ERROR_INVALID_INPUT;
+
+  position_clear(pos);
+
+  // 1. Piece placement, from row 0 (rank 8) down to row 7 (rank 1). Every
+  // rank must fill exactly 8 files.
+  int row = 0, col = 0;
+  const char *p = fen;
+  for (; *p && *p != ' '; p++) {
+    if (*p == '/') {
+      if (col != 8 || ++row > 7)
+        return ERROR_INVALID_INPUT;
+      col = 0;
+    } else if (*p >= '1' && *p <= '8') {
+      col += *p - '0';
+      if (col > 8)
+        return ERROR_INVALID_INPUT;
+    } else {
+      int type = piece_type_from_char(*p);
+      if (type == EMPTY || !is_valid_position(row, col))
+        return ERROR_INVALID_INPUT;
+      int color = isupper((unsigned char)*p) ? WHITE : BLACK;
+      put_piece(&pos->board, make_square(row, col), make_piece(type, color));
+      col++;
+    }
+  }
+  if (row != 7 || col != 8)
+    return ERROR_INVALID_INPUT;
+
+  // Move generation, SEE and the evaluators rely on one king per side and
+  // on pawns never standing where they could not move from
+  const board_t *board = &pos->board;
+  bitboard_t back_ranks = ROW_0 | ROW_7;
+  if (popcount(board->pieces[WHITE][KING]) != 1 ||
+      popcount(board->pieces[BLACK][KING]) != 1 ||
+      ((board->pieces[WHITE][PAWN] | board->pieces[BLACK][PAWN]) &
+       back_ranks)) {
+    return ERROR_INVALID_INPUT;
+  }
+
+  // 2. Side to move
+  while (*p == ' ')
+    p++;
+  if (*p == 'b')
+    pos->side_to_move = BLACK;
+  if (*p)
+    p++;
+
+  // 3. Castling rights
+  while (*p == ' ')
+    p++;
+  for (; *p && *p != ' '; p++) {
+    if (*p == 'K')
+      pos->castling |= CASTLE_WHITE_KINGSIDE;
+    else if (*p == 'Q')
+      pos->castling |= CASTLE_WHITE_QUEENSIDE;
+    else if (*p == 'k')
+      pos->castling |= CASTLE_BLACK_KINGSIDE;
+    else if (*p == 'q')
+      pos->castling |= CASTLE_BLACK_QUEENSIDE;
+  }
+
+  // 4. En passant square
+  while (*p == ' ')
+    p++;
+  if (*p >= 'a' && *p <= 'h' && p[1] >= '1' && p[1] <= '8') {
+    pos->ep_square = make_square('8' - p[1], *p - 'a');
+    p += 2;
+  } else if (*p) {
+    p++;
+  }
+
+  // 5. Move counters (optional)
+  while (*p == ' ')
+    p++;
+  if (isdigit((unsigned char)*p)) {
+    pos->halfmove_clock = (int)strtol(p, (char **)&p, 10);
+    while (*p == ' ')
+      p++;
+    if (isdigit((unsigned char)*p))
+      pos->fullmove_number = (int)strtol(p, NULL, 10);
+  }
+
+  // Like make_move, only keep an en passant square that can be used, so equal
+  // positions get equal keys
+  if (pos->ep_square != SQUARE_NONE &&
+      !(pawn_attacks[opponent_of(pos->side_to_move)][pos->ep_square] &
+        pos->board.pieces[pos->side_to_move][PAWN])) {
+    pos->ep_square = SQUARE_NONE;
+  }
+
+  pos->key = position_compute_key(pos);
+  pos->pawn_key = position_compute_pawn_key(pos);
+  return ERROR_NONE;
+}
+
+uint64_t position_compute_key(const position_t *pos) {
+  uint64_t key = 0;
+
+  bitboard_t occupied = pos->board.occupied[NONE];
+  while (occupied) {
+    int sq = pop_lsb(&occupied);
+    piece_t piece = piece_on(&pos->board, sq);
+    key ^= zobrist_piece[color_of(piece)][type_of(piece)][sq];
+  }
+
+  key ^= zobrist_castling[pos->castling];
+  if (pos->ep_square != SQUARE_NONE)
+    key ^= zobrist_ep[square_col(pos->ep_square)];
+  if (pos->side_to_move == BLACK)
+    key ^= zobrist_side;
+  return key;
+}
+
+// The part of the key the pawn structure evaluation depends on
+static inline uint64_t pawn_zobrist(int color, int type, int square) {
+  return (type == PAWN) ? zobrist_piece[color][PAWN][square] : 0;
+}
+
+uint64_t position_compute_pawn_key(const position_t *pos) {
+  uint64_t key = 0;
+  for (int color = WHITE; color <= BLACK; color++) {
+    bitboard_t pawns = pos->board.pieces[color][PAWN];
+    while (pawns) {
+      key ^= zobrist_piece[color][PAWN][pop_lsb(&pawns)];
+    }
+  }
+  return key;
+}
+
+int position_in_check(const position_t *pos) {
+  bitboard_t king = pos->board.pieces[pos->side_to_move][KING];
+  return king &&
+         is_square_attacked(&pos->board, lsb(king),
+                            opponent_of(pos->side_to_move));
+}
+
+void make_move(position_t *pos, move_t move) {
+  board_t *board = &pos->board;
+  undo_t *undo = &pos->history[pos->ply++];
+  int us = pos->side_to_move;
+  int them = opponent_of(us);
+
+  undo->key = pos->key;
+  undo->pawn_key = pos->pawn_key;
+  undo->move = move;
+  undo->captured = NO_PIECE;
+  undo->castling = (uint8_t)pos->castling;
+  undo->ep_square = (int8_t)pos->ep_square;
+  undo->halfmove_clock = (uint16_t)pos->halfmove_clock;
+
+  int from = move_from(move);
+  int to = move_to(move);
+  int flags = move_flags(move);
+  uint64_t key = pos->key ^ zobrist_side ^ zobrist_castling[pos->castling];
+  uint64_t pawn_key = pos->pawn_key;
+  nnue_stack_t *nnue = pos->nnue;
+  if (nnue) {
+    nnue_push(nnue);
+  }
+
+  if (pos->ep_square != SQUARE_NONE) {
+    key ^= zobrist_ep[square_col(pos->ep_square)];
+  }
+  pos->ep_square = SQUARE_NONE;
+  pos->halfmove_clock++;
+
+  if (flags == MOVE_CASTLING) {
+    // The rook jumps to the square the king passed over
+    int kingside = to > from;
+    int rook_from = kingside ? from + 3 : from - 4;
+    int rook_to = kingside ? from + 1 : from - 1;
+    put_piece(board, rook_to, remove_piece(board, rook_from));
+    key ^= zobrist_piece[us][ROOK][rook_from];
+    key ^= zobrist_piece[us][ROOK][rook_to];
+    if (nnue) {
+      nnue_remove_piece(nnue, make_piece(ROOK, us), rook_from);
+      nnue_add_piece(nnue, make_piece(ROOK, us), rook_to);
+    }
+  } else if (flags == MOVE_EN_PASSANT) {
+    // The captured pawn sits behind the target square
+    int captured_square = to + ((us == WHITE) ? 8 : -8);
+    undo->captured = remove_piece(board, captured_square);
+    key ^= zobrist_piece[them][PAWN][captured_square];
+    pawn_key ^= zobrist_piece[them][PAWN][captured_square];
+    if (nnue) {
+      nnue_remove_piece(nnue, undo->captured, captured_square);
+    }
+  } else if (board->occupied[them] & square_bb(to)) {
+    undo->captured = remove_piece(board, to);
+    key ^= zobrist_piece[them][type_of(undo->captured)][to];
+    pawn_key ^= pawn_zobrist(them, type_of(undo->captured), to);
+    if (nnue) {
+      nnue_remove_piece(nnue, undo->captured, to);
+    }
+  }
+
+  piece_t piece = remove_piece(board, from);
+  key ^= zobrist_piece[us][type_of(piece)][from];
+  pawn_key ^= pawn_zobrist(us, type_of(piece), from);
+  if (nnue) {
+    nnue_remove_piece(nnue, piece, from);
+  }
+  if (type_of(piece) == PAWN || undo->captured != NO_PIECE) {
+    pos->halfmove_clock = 0;
+  }
+
+  if (flags == MOVE_PROMOTION) {
+    piece = make_piece(move_promotion(move), us);
+  }
+  put_piece(board, to, piece);
+  key ^= zobrist_piece[us][type_of(piece)][to];
+  pawn_key ^= pawn_zobrist(us, type_of(piece), to);
+  if (nnue) {
+    nnue_add_piece(nnue, piece, to);
+  }
+
+  // Only record an en passant square an enemy pawn can actually use
+  if (type_of(piece) == PAWN && (from ^ to) == 16) {
+    int ep_square = (from + to) / 2;
+    if (pawn_attacks[us][ep_square] & board->pieces[them][PAWN]) {
+      pos->ep_square = ep_square;
+      key ^= zobrist_ep[square_col(ep_square)];
+    }
+  }
+
+  pos->castling &= castling_mask[from] & castling_mask[to];
+  pos->key = key ^ zobrist_castling[pos->castling];
+  pos->pawn_key = pawn_key;
+
+  if (us == BLACK) {
+    pos->fullmove_number++;
+  }
+  pos->side_to_move = them;
+}
+
+void make_null_move(position_t *pos) {
+  undo_t *undo = &pos->history[pos->ply++];
+
+  undo->key = pos->key;
+  undo->pawn_key = pos->pawn_key;
+  undo->move = MOVE_NONE;
+  undo->captured = NO_PIECE;
+  undo->castling = (uint8_t)pos->castling;
+  undo->ep_square = (int8_t)pos->ep_square;
+  undo->halfmove_clock = (uint16_t)pos->halfmove_clock;
+  if (pos->nnue) {
+    nnue_push(pos->nnue); // Same pieces, same accumulator
+  }
+
+  pos->key ^= zobrist_side;
+  if (pos->ep_square != SQUARE_NONE) {
+    pos->key ^= zobrist_ep[square_col(pos->ep_square)];
+    pos->ep_square = SQUARE_NONE;
+  }
+  // Positions before a null move can't be repeated by real moves after it
+  pos->halfmove_clock = 0;
+  pos->side_to_move = opponent_of(pos->side_to_move);
+}
+
+void unmake_move(position_t *pos) {
+  if (pos->ply == 0)
+    return;
+
+  board_t *board = &pos->board;
+  undo_t *undo = &pos->history[--pos->ply];
+  move_t move = undo->move;
+  if (pos->nnue) {
+    nnue_pop(pos->nnue);
+  }
+
+  if (move == MOVE_NONE) {
+    pos->side_to_move = opponent_of(pos->side_to_move);
+    pos->key = undo->key;
+    pos->ep_square = undo->ep_square;
+    pos->halfmove_clock = undo->halfmove_clock;
+    return;
+  }
+
+  int from = move_from(move);
+  int to = move_to(move);
+  int flags = move_flags(move);
+  int them = pos->side_to_move;
+  int us = opponent_of(them);
+
+  pos->side_to_move = us;
+  if (us == BLACK) {
+    pos->fullmove_number--;
+  }
+
+  piece_t piece = remove_piece(board, to);
+  if (flags == MOVE_PROMOTION) {
+    piece = make_piece(PAWN, us);
+  }
+  put_piece(board, from, piece);
+
+  if (flags == MOVE_CASTLING) {
+    int kingside = to > from;
+    int rook_from = kingside ? from + 3 : from - 4;
+    int rook_to = kingside ? from + 1 : from - 1;
+    put_piece(board, rook_from, remove_piece(board, rook_to));
+  } else if (flags == MOVE_EN_PASSANT) {
+    int captured_square = to + ((us == WHITE) ? 8 : -8);
+    put_piece(board, captured_square, undo->captured);
+  } else if (undo->captured != NO_PIECE) {
+    put_piece(board, to, undo->captured);
+  }
+
+  pos->key = undo->key;
+  pos->pawn_key = undo->pawn_key;
+  pos->castling = undo->castling;
+  pos->ep_square = undo->ep_square;
+  pos->halfmove_clock = undo->halfmove_clock;
+}
@@ -0,0 +1,88 @@
+#ifndef POSITION_H
+#define POSITION_H
+
+#include "board.h"
+#include "move.h"
+
+// Longest game a position can record
+#define POSITION_MAX_PLY 1024
+
+#define SQUARE_NONE (-1)
+
+#define START_FEN "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1"
+
+// Castling rights, stored as a bit mask in position_t.castling
+enum {
+  CASTLE_WHITE_KINGSIDE = 1,
+  CASTLE_WHITE_QUEENSIDE = 2,
+  CASTLE_BLACK_KINGSIDE = 4,
+  CASTLE_BLACK_QUEENSIDE = 8,
+  CASTLE_ALL = 15
+};
+
+// State that a move destroys and unmake_move needs back
+typedef struct {
+  uint64_t key; // Position key before the move
+  uint64_t pawn_key;
+  move_t move;
+  uint8_t castling;
+  int8_t ep_square;
+  uint16_t halfmove_clock;
+  piece_t captured; // NO_PIECE if no capture
+} undo_t;
+
+struct nnue_stack;
+struct pawn_table;
+
+// A complete, self-contained chess position. Nothing here refers to global
+// game or UI state, so any number of positions can be searched side by side.
+typedef struct {
+  board_t board;
+  uint64_t key;       // Zobrist key, kept up to date by make/unmake_move
+  uint64_t pawn_key;  // Same, of the pawns alone
+  int side_to_move;   // WHITE or BLACK
+  int castling;       // CASTLE_* bits
+  int ep_square;      // Square a pawn can capture en passant, or SQUARE_NONE
+  int halfmove_clock; // Plies since the last capture or pawn move
+  int fullmove_number;
+  int ply;            // Number of moves on the undo stack
+  undo_t history[POSITION_MAX_PLY];
+  // NNUE accumulators make/unmake_move keep in step, and a cache for the
+  // pawn structure evaluation, or NULL. A copy shares them, so each search
+  // thread attaches its own.
+  struct nnue_stack *nnue;
+  struct pawn_table *pawn_table;
+} position_t;
+
+void position_clear(position_t *pos);
+void position_set_start(position_t *pos);
+// Set up pos from a FEN. Returns ERROR_INVALID_INPUT, leaving pos unusable,
+// unless the placement has 8 ranks of 8 files, one king per side and no
+// pawns on the first or last rank.
+ErrorCode position_set_fen(position_t *pos, const char *fen);
+
+// Zobrist keys of pos computed from scratch; pos->key and pos->pawn_key
+// always equal them
+uint64_t position_compute_key(const position_t *pos);
+uint64_t position_compute_pawn_key(const position_t *pos);
+
+// Whether move takes an enemy piece (en passant included)
+static inline int move_is_capture(const position_t *pos, move_t move) {
+  return move_flags(move) == MOVE_EN_PASSANT ||
+         (pos->board.occupied[opponent_of(pos->side_to_move)] &
+          square_bb(move_to(move))) != 0;
+}
+
+// Whether the side to move is in check
+int position_in_check(const position_t *pos);
+
+// make_move expects a pseudo-legal move for the side to move; unmake_move
+// takes back the last move made. Both are O(1).
+void make_move(position_t *pos, move_t move);
+void unmake_move(position_t *pos);
+
+// Pass the turn without moving (for null-move pruning); undone by
+// unmake_move like any other move. Not allowed while in check.
+void make_null_move(position_t *pos);
+
+#endif // POSITION_H
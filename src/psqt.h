@@ -0,0 +1,25 @@
+#ifndef PSQT_H
+#define PSQT_H
+
+#include "board.h"
+
+// Middlegame and endgame halves of a tapered score
+enum { PHASE_MG = 0, PHASE_EG = 1 };
+
+// Phase of a board with all the pieces of the starting position; a board
+// with only kings and pawns has phase 0
+#define PHASE_MAX 24
+
+// Evaluation parameters the tables are built from, for White with rank 8
+// first, the same orientation as the squares. Black uses them mirrored.
+extern int psqt_piece_value[2][PIECE_TYPE_COUNT]; // [PHASE_*][type]
+extern int psqt_square_bonus[2][PIECE_TYPE_COUNT][SQUARE_COUNT];
+
+// Must be called once before any piece is put on a board
+void init_psqt(void);
+
+// Rebuild psqt_mg/psqt_eg after the parameters changed. Boards set up
+// earlier keep their old totals.
+void psqt_rebuild(void);
+
+#endif // PSQT_H
@@ -100,28 +100,30 @@ void draw_board(SDL_Renderer *renderer) {
   }
 }
 
-void draw_piece(SDL_Renderer *renderer, int row, int col, piece_t *piece) {
-  if (!renderer || !piece || !is_valid_position(row, col)) {
+void draw_piece(SDL_Renderer *renderer, int row, int col, piece_t piece,
+                int theme) {
+  if (!renderer || !is_valid_position(row, col)) {
     fprintf(stderr, "Invalid parameters to draw_piece\n");
     return;
   }
 
-  if (piece->type == EMPTY || piece->color == NONE) {
+  int type = type_of(piece);
+  int color = color_of(piece);
+  if (type == EMPTY || color == NONE) {
     return; // Nothing to draw
   }
 
   // Get the appropriate sprite sheet from resource manager
-  SDL_Texture *sprite_map =
-      get_piece_sprite(piece->type, piece->color, piece->theme);
+  SDL_Texture *sprite_map = get_piece_sprite(type, color, theme);
   if (!sprite_map) {
     fprintf(stderr,
             "Failed to get sprite for piece type %d, color %d, theme %d\n",
-            piece->type, piece->color, piece->theme);
+            type, color, theme);
     return;
   }
 
   // Calculate source rectangle
-  int src_x = PIECE_WIDTH * (piece->type - 1);
+  int src_x = PIECE_WIDTH * (type - 1);
   SDL_Rect src_rect = {src_x, 0, PIECE_WIDTH, PIECE_HEIGHT};
 
   // Calculate destination rectangle
@@ -134,36 +136,35 @@ void draw_piece(SDL_Renderer *renderer, int row, int col, piece_t *piece) {
   SDL_RenderCopy(renderer, sprite_map, &src_rect, &dest_rect);
 }
 
-void draw_all_pieces(SDL_Renderer *renderer, board_t *board) {
+void draw_all_pieces(SDL_Renderer *renderer, board_t *board, int theme) {
   if (!renderer || !board)
     return;
 
-  for (int row = 0; row < BOARD_SIZE; row++) {
-    for (int col = 0; col < BOARD_SIZE; col++) {
-      piece_t *piece = get_piece_at(board, row, col);
-      if (piece) {
-        draw_piece(renderer, row, col, piece);
-      }
-    }
+  // Only visit occupied squares
+  bitboard_t occupied = board->occupied[NONE];
+  while (occupied) {
+    int sq = pop_lsb(&occupied);
+    int row = square_row(sq);
+    int col = square_col(sq);
+    draw_piece(renderer, row, col, piece_on(board, sq), theme);
   }
 }
 
-void draw_possible_moves(SDL_Renderer *renderer,
-                         int possible_moves[BOARD_SIZE][BOARD_SIZE],
+void draw_possible_moves(SDL_Renderer *renderer, bitboard_t possible_moves,
                          board_t *board) {
-  if (!renderer || !possible_moves)
+  if (!renderer || !board)
     return;
 
   for (int row = 0; row < BOARD_SIZE; row++) {
     for (int col = 0; col < BOARD_SIZE; col++) {
-      if (possible_moves[row][col]) {
+      if (possible_moves & square_bb(make_square(row, col))) {
         SDL_Rect square = get_square_rect(renderer, row, col);
         // Draw a semi-transparent overlay for possible moves
         // For now, just draw a border
         SDL_Rect border = {square.x + 2, square.y + 2, square.w - 4,
                            square.h - 4};
 
-        if (board->squares[row][col].piece.type != EMPTY) {
+        if (board->occupied[NONE] & square_bb(make_square(row, col))) {
           // Capture move - red border
           SDL_SetRenderDrawColor(renderer, 255, 0, 0, 50);
         } else {
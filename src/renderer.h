@@ -13,9 +13,9 @@ void cleanup_renderer(void);
 void clear_screen(SDL_Renderer *renderer);
 void draw_background(SDL_Renderer *renderer);
 void draw_board(SDL_Renderer *renderer);
-void draw_piece(SDL_Renderer *renderer, int row, int col, piece_t* piece);
-void draw_possible_moves(SDL_Renderer *renderer, int possible_moves[BOARD_SIZE][BOARD_SIZE], board_t* board);
-void draw_all_pieces(SDL_Renderer *renderer, board_t* board);
+void draw_piece(SDL_Renderer *renderer, int row, int col, piece_t piece, int theme);
+void draw_possible_moves(SDL_Renderer *renderer, bitboard_t possible_moves, board_t* board);
+void draw_all_pieces(SDL_Renderer *renderer, board_t* board, int theme);
 
 // Utility functions
 int get_cell_size(SDL_Renderer *renderer);
@@ -0,0 +1,736 @@
+// clock_gettime is POSIX, hidden by -std=c11
+#define _POSIX_C_SOURCE 199309L
+#include "search.h"
+#include "eval.h"
+#include "movegen.h"
+#include "movepick.h"
+#include "nnue.h"
+#include "pawns.h"
+#include "timeman.h"
+#include "timer.h"
+#include "tt.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// How many nodes pass between checks of the clock and node limit
+#define CHECK_INTERVAL 2048
+
+// Root aspiration window, widened on every fail
+#define ASPIRATION_DEPTH 4
+#define ASPIRATION_WINDOW 25
+
+// Null move: minimum depth, and the depth from which a cutoff is verified
+// by a normal reduced search even with plenty of material
+#define NULL_MOVE_DEPTH 3
+#define NULL_VERIFY_DEPTH 10
+
+#define LMR_DEPTH 3
+#define LMR_MOVE_COUNT 3
+
+// Futility margins grow with the remaining depth
+#define FUTILITY_DEPTH 3
+#define FUTILITY_MARGIN 150
+#define REVERSE_FUTILITY_DEPTH 6
+#define REVERSE_FUTILITY_MARGIN 80
+
+// Working state of one search thread. Thread 0 is the main thread: it
+// checks the limits, reports progress and decides when the search ends.
+// The others are Lazy SMP helpers that search the same root, sharing only
+// the transposition table, so their results steer the main thread.
+typedef struct {
+  int index;
+  position_t pos;
+  const search_limits_t *limits;
+  int64_t start_time;
+  _Atomic uint64_t nodes; // Written only by this thread, summed by thread 0
+  int completed_depth;
+  search_info_t info; // Last completed iteration
+  move_t pv[MAX_PLY][MAX_PLY]; // Principal variation found below each ply
+  int pv_length[MAX_PLY];
+  uint64_t best_move_nodes; // Nodes below the current best root move
+  move_t killers[MAX_PLY][2]; // Quiet moves that cut off at each ply
+  history_t history;
+  int null_min_ply; // No null moves before this ply (verification search)
+  search_stats_t stats;
+  nnue_stack_t nnue; // Accumulators along the line being searched
+  pawn_table_t pawns;
+  pthread_t handle;
+} search_thread_t;
+
+static struct {
+  tt_t tt;
+  atomic_int stop;
+  atomic_int pondering;
+  _Atomic int64_t limits_start; // When the limits started to count
+  time_manager_t time; // Main thread only
+  int thread_count;
+  int active_threads; // Threads search_run allocated, at most thread_count
+  search_features_t features;
+  search_thread_t *threads[SEARCH_MAX_THREADS];
+} g_search = {.thread_count = 1, .features = {1, 1, 1, 1, 1}};
+
+ErrorCode search_init(size_t hash_mb) {
+  search_cleanup();
+  atomic_init(&g_search.stop, 0);
+  atomic_init(&g_search.pondering, 0);
+  atomic_init(&g_search.limits_start, 0);
+  return tt_init(&g_search.tt, hash_mb, 1);
+}
+
+void search_set_threads(int count) {
+  if (count < 1)
+    count = 1;
+  if (count > SEARCH_MAX_THREADS)
+    count = SEARCH_MAX_THREADS;
+  g_search.thread_count = count;
+}
+
+void search_set_features(const search_features_t *features) {
+  g_search.features = *features;
+}
+
+void search_get_features(search_features_t *features) {
+  *features = g_search.features;
+}
+
+void search_cleanup(void) { tt_free(&g_search.tt); }
+
+void search_new_game(void) {
+  if (g_search.tt.buckets)
+    tt_clear(&g_search.tt);
+}
+
+void search_stop(void) { atomic_store(&g_search.stop, 1); }
+
+void search_ponderhit(void) {
+  atomic_store(&g_search.limits_start, time_now_ms());
+  atomic_store(&g_search.pondering, 0);
+}
+
+// Helpers stop at once; the main thread always finishes its first
+// iteration so there is a move to play
+static inline int should_stop(const search_thread_t *t) {
+  return atomic_load_explicit(&g_search.stop, memory_order_relaxed) &&
+         (t->index > 0 || t->completed_depth > 0);
+}
+
+// Returns the thread's node count including this node
+static inline uint64_t count_node(search_thread_t *t) {
+  uint64_t nodes = atomic_load_explicit(&t->nodes, memory_order_relaxed) + 1;
+  atomic_store_explicit(&t->nodes, nodes, memory_order_relaxed);
+  return nodes;
+}
+
+static uint64_t total_nodes(int thread_count) {
+  uint64_t nodes = 0;
+  for (int i = 0; i < thread_count; i++) {
+    nodes += atomic_load_explicit(&g_search.threads[i]->nodes,
+                                  memory_order_relaxed);
+  }
+  return nodes;
+}
+
+// Mate scores are stored relative to the node rather than the root, so the
+// same entry is right at any distance from the root
+static int score_to_tt(int score, int ply) {
+  if (score >= SCORE_MATE_BOUND)
+    return score + ply;
+  if (score <= -SCORE_MATE_BOUND)
+    return score - ply;
+  return score;
+}
+
+static int score_from_tt(int score, int ply) {
+  if (score >= SCORE_MATE_BOUND)
+    return score - ply;
+  if (score <= -SCORE_MATE_BOUND)
+    return score + ply;
+  return score;
+}
+
+// Fifty-move rule, or the position already occurred since the last capture
+// or pawn move (in the game or in the search)
+static int is_draw(const position_t *pos) {
+  if (pos->halfmove_clock >= 100)
+    return 1;
+
+  int oldest = pos->ply - pos->halfmove_clock;
+  if (oldest < 0)
+    oldest = 0;
+  for (int i = pos->ply - 4; i >= oldest; i -= 2) {
+    if (pos->history[i].key == pos->key)
+      return 1;
+  }
+  return 0;
+}
+
+// The pawn table counts its own probes; bring them into the stats
+static void collect_pawn_stats(search_thread_t *t) {
+  t->stats.pawn_table_probes = t->pawns.probes;
+  t->stats.pawn_table_hits = t->pawns.hits;
+}
+
+void search_stats_add(search_stats_t *total, const search_stats_t *stats) {
+  total->pvs_researches += stats->pvs_researches;
+  total->aspiration_researches += stats->aspiration_researches;
+  total->null_move_tries += stats->null_move_tries;
+  total->null_move_cutoffs += stats->null_move_cutoffs;
+  total->null_move_verifications += stats->null_move_verifications;
+  total->lmr_reductions += stats->lmr_reductions;
+  total->lmr_researches += stats->lmr_researches;
+  total->futility_prunes += stats->futility_prunes;
+  total->reverse_futility_prunes += stats->reverse_futility_prunes;
+  total->pawn_table_probes += stats->pawn_table_probes;
+  total->pawn_table_hits += stats->pawn_table_hits;
+}
+
+// Pieces other than pawns and the king; without them the side to move is
+// likely to be in zugzwang, where passing would be an advantage
+static int non_pawn_pieces(const position_t *pos, int color) {
+  const board_t *board = &pos->board;
+  return popcount(board->occupied[color] & ~board->pieces[color][PAWN] &
+                  ~board->pieces[color][KING]);
+}
+
+static void check_limits(search_thread_t *t) {
+  const search_limits_t *limits = t->limits;
+
+  if (t->index > 0 || t->completed_depth == 0)
+    return;
+  // Until the opponent moves there is no hurry
+  if (atomic_load(&g_search.pondering))
+    return;
+
+  if (limits->nodes && total_nodes(g_search.active_threads) >= limits->nodes) {
+    search_stop();
+  } else if (timeman_out_of_time(&g_search.time,
+                                 time_now_ms() -
+                                     atomic_load(&g_search.limits_start))) {
+    search_stop();
+  }
+}
+
+static void update_pv(search_thread_t *t, int ply, move_t move) {
+  t->pv[ply][0] = move;
+  memcpy(&t->pv[ply][1], t->pv[ply + 1],
+         (size_t)t->pv_length[ply + 1] * sizeof(move_t));
+  t->pv_length[ply] = t->pv_length[ply + 1] + 1;
+}
+
+// Remember a quiet move that caused a beta cutoff, so it is tried early in
+// sibling nodes and wherever the same situation comes up again
+static void update_quiet_stats(search_thread_t *t, int ply, move_t move,
+                               const move_t *quiets, int quiet_count,
+                               int depth) {
+  move_t *killers = t->killers[ply];
+  if (killers[0] != move) {
+    killers[1] = killers[0];
+    killers[0] = move;
+  }
+  history_update(&t->history, &t->pos, move, quiets, quiet_count, depth);
+}
+
+// Search only captures and promotions (all moves when in check) until the
+// position is quiet, so the static evaluation is never taken in the middle
+// of an exchange. The side to move may also stand pat on the evaluation.
+// Captures that lose material by SEE are never searched.
+static int quiescence(search_thread_t *t, int alpha, int beta, int ply) {
+  position_t *pos = &t->pos;
+
+  t->pv_length[ply] = 0;
+  if ((count_node(t) % CHECK_INTERVAL) == 0)
+    check_limits(t);
+  if (should_stop(t))
+    return 0;
+
+  if (ply >= MAX_PLY - 1 || pos->ply >= POSITION_MAX_PLY - 1)
+    return evaluate(pos);
+
+  tt_data_t entry;
+  move_t tt_move = MOVE_NONE;
+  if (tt_probe(&g_search.tt, pos->key, &entry)) {
+    tt_move = entry.move;
+    int score = score_from_tt(entry.score, ply);
+    if (entry.bound == BOUND_EXACT ||
+        (entry.bound == BOUND_LOWER && score >= beta) ||
+        (entry.bound == BOUND_UPPER && score <= alpha))
+      return score;
+  }
+
+  int in_check = position_in_check(pos);
+  int best_score = -SCORE_INFINITE;
+  int eval = SCORE_NONE;
+  if (!in_check) {
+    eval = evaluate(pos);
+    best_score = eval;
+    if (best_score >= beta)
+      return best_score;
+    if (best_score > alpha)
+      alpha = best_score;
+  }
+
+  // In check every evasion is searched, or a mate would go unnoticed
+  move_picker_t picker;
+  if (in_check)
+    move_picker_init(&picker, pos, tt_move, NULL, NULL);
+  else
+    move_picker_init_captures(&picker, pos, tt_move);
+
+  int original_alpha = alpha;
+  move_t best_move = MOVE_NONE;
+  int move_count = 0;
+  move_t move;
+
+  while ((move = next_move(&picker)) != MOVE_NONE) {
+    move_count++;
+
+    make_move(pos, move);
+    int score = -quiescence(t, -beta, -alpha, ply + 1);
+    unmake_move(pos);
+
+    if (should_stop(t))
+      return 0;
+
+    if (score > best_score) {
+      best_score = score;
+      if (score > alpha) {
+        best_move = move;
+        alpha = score;
+        update_pv(t, ply, move);
+        if (alpha >= beta)
+          break;
+      }
+    }
+  }
+
+  if (in_check && move_count == 0)
+    return -SCORE_MATE + ply;
+
+  int bound = BOUND_UPPER;
+  if (best_score >= beta)
+    bound = BOUND_LOWER;
+  else if (best_score > original_alpha)
+    bound = BOUND_EXACT;
+  tt_store(&g_search.tt, pos->key, best_move, score_to_tt(best_score, ply),
+           eval, 0, bound);
+  return best_score;
+}
+
+// Principal variation search: a node with a window wider than one point is
+// on the principal variation; every other node only has to prove the score
+// is above or below a bound, which lets the selective techniques cut it short
+static int alpha_beta(search_thread_t *t, int alpha, int beta, int depth,
+                      int ply) {
+  position_t *pos = &t->pos;
+  const search_features_t *features = &g_search.features;
+
+  if (depth <= 0)
+    return quiescence(t, alpha, beta, ply);
+
+  t->pv_length[ply] = 0;
+  if ((count_node(t) % CHECK_INTERVAL) == 0)
+    check_limits(t);
+  if (should_stop(t))
+    return 0;
+
+  if (ply > 0 && is_draw(pos))
+    return SCORE_DRAW;
+
+  if (ply >= MAX_PLY - 1 || pos->ply >= POSITION_MAX_PLY - 1)
+    return evaluate(pos);
+
+  int pv_node = beta - alpha > 1;
+
+  tt_data_t entry;
+  int tt_hit = tt_probe(&g_search.tt, pos->key, &entry);
+  move_t tt_move = MOVE_NONE;
+  if (tt_hit) {
+    tt_move = entry.move;
+    int score = score_from_tt(entry.score, ply);
+    if (!pv_node && entry.depth >= depth &&
+        (entry.bound == BOUND_EXACT ||
+         (entry.bound == BOUND_LOWER && score >= beta) ||
+         (entry.bound == BOUND_UPPER && score <= alpha)))
+      return score;
+  }
+
+  int in_check = position_in_check(pos);
+  int eval = SCORE_NONE;
+  if (!in_check)
+    eval = (tt_hit && entry.eval != SCORE_NONE) ? entry.eval : evaluate(pos);
+
+  if (!pv_node && !in_check && ply > 0) {
+    // Reverse futility: so far above beta that no quiet reply will matter
+    if (features->futility && depth <= REVERSE_FUTILITY_DEPTH &&
+        eval - REVERSE_FUTILITY_MARGIN * depth >= beta &&
+        eval < SCORE_MATE_BOUND) {
+      t->stats.reverse_futility_prunes++;
+      return eval;
+    }
+
+    // Null move: if passing still leaves us above beta after a reduced
+    // search, a real move almost certainly would too
+    int us = pos->side_to_move;
+    int pieces = non_pawn_pieces(pos, us);
+    if (features->null_move && depth >= NULL_MOVE_DEPTH && eval >= beta &&
+        pieces > 0 && ply >= t->null_min_ply &&
+        pos->history[pos->ply - 1].move != MOVE_NONE &&
+        beta > -SCORE_MATE_BOUND && beta < SCORE_MATE_BOUND) {
+      int reduction = 3 + depth / 6;
+      t->stats.null_move_tries++;
+
+      make_null_move(pos);
+      int score = -alpha_beta(t, -beta, -beta + 1, depth - 1 - reduction,
+                              ply + 1);
+      unmake_move(pos);
+
+      if (should_stop(t))
+        return 0;
+
+      if (score >= beta) {
+        if (score >= SCORE_MATE_BOUND)
+          score = beta;
+
+        // With a single piece left zugzwang is a real danger, and deep
+        // cutoffs are costly to get wrong: confirm with a normal reduced
+        // search that may not pass in its first plies
+        if (depth < NULL_VERIFY_DEPTH && pieces > 1) {
+          t->stats.null_move_cutoffs++;
+          return score;
+        }
+
+        // Restore the restriction afterwards rather than clearing it, so a
+        // verification inside another one leaves the outer one in force
+        t->stats.null_move_verifications++;
+        int saved_min_ply = t->null_min_ply;
+        t->null_min_ply = ply + 3 * (depth - reduction) / 4;
+        int verified = alpha_beta(t, beta - 1, beta, depth - reduction, ply);
+        t->null_min_ply = saved_min_ply;
+
+        if (should_stop(t))
+          return 0;
+        if (verified >= beta) {
+          t->stats.null_move_cutoffs++;
+          return score;
+        }
+      }
+    }
+  }
+
+  // Quiet moves that can't lift a hopeless position back to alpha
+  int futile = features->futility && !pv_node && !in_check &&
+               depth <= FUTILITY_DEPTH &&
+               eval + FUTILITY_MARGIN * depth <= alpha;
+
+  move_picker_t picker;
+  move_picker_init(&picker, pos, tt_move, t->killers[ply], &t->history);
+
+  // Killers of the next ply only make sense for this node's children
+  t->killers[ply + 1][0] = t->killers[ply + 1][1] = MOVE_NONE;
+
+  int best_score = -SCORE_INFINITE;
+  move_t best_move = MOVE_NONE;
+  int move_count = 0;
+  move_t quiets[MAX_MOVES];
+  int quiet_count = 0;
+  move_t move;
+
+  while ((move = next_move(&picker)) != MOVE_NONE) {
+    move_count++;
+    int quiet = !move_is_capture(pos, move) &&
+                move_flags(move) != MOVE_PROMOTION;
+
+    uint64_t nodes_before =
+        atomic_load_explicit(&t->nodes, memory_order_relaxed);
+    make_move(pos, move);
+    int gives_check = position_in_check(pos);
+
+    // Always search one move so the node has a real score
+    if (futile && quiet && !gives_check && best_score > -SCORE_MATE_BOUND) {
+      unmake_move(pos);
+      t->stats.futility_prunes++;
+      continue;
+    }
+
+    int new_depth = depth - 1;
+    int reduction = 0;
+    if (features->lmr && quiet && !in_check && !gives_check &&
+        depth >= LMR_DEPTH && move_count > LMR_MOVE_COUNT) {
+      reduction = 1 + (move_count > 8) + (depth >= 8) - pv_node;
+      if (reduction > new_depth - 1)
+        reduction = new_depth - 1;
+    }
+
+    int score = 0;
+    int done = 0;
+    if (reduction > 0) {
+      t->stats.lmr_reductions++;
+      score = -alpha_beta(t, -alpha - 1, -alpha, new_depth - reduction,
+                          ply + 1);
+      done = score <= alpha;
+      if (!done)
+        t->stats.lmr_researches++;
+    }
+    if (!done && move_count > 1 && features->pvs) {
+      score = -alpha_beta(t, -alpha - 1, -alpha, new_depth, ply + 1);
+      done = score <= alpha || score >= beta;
+      if (!done)
+        t->stats.pvs_researches++;
+    }
+    if (!done)
+      score = -alpha_beta(t, -beta, -alpha, new_depth, ply + 1);
+    unmake_move(pos);
+
+    if (should_stop(t))
+      return 0;
+
+    if (score > best_score) {
+      best_score = score;
+      if (score > alpha) {
+        best_move = move;
+        alpha = score;
+        update_pv(t, ply, move);
+        if (ply == 0)
+          t->best_move_nodes =
+              atomic_load_explicit(&t->nodes, memory_order_relaxed) -
+              nodes_before;
+        if (alpha >= beta) {
+          if (quiet)
+            update_quiet_stats(t, ply, move, quiets, quiet_count, depth);
+          break;
+        }
+      }
+    }
+
+    if (quiet)
+      quiets[quiet_count++] = move;
+  }
+
+  // No legal move: checkmate or stalemate
+  if (move_count == 0)
+    return in_check ? -SCORE_MATE + ply : SCORE_DRAW;
+
+  int bound = BOUND_UPPER;
+  if (best_score >= beta)
+    bound = BOUND_LOWER;
+  else if (best_move != MOVE_NONE)
+    bound = BOUND_EXACT;
+  tt_store(&g_search.tt, pos->key, best_move, score_to_tt(best_score, ply),
+           eval, depth, bound);
+  return best_score;
+}
+
+// Search the root in a narrow window around the previous iteration's score,
+// widening it on whichever side the score falls outside
+static int aspiration_search(search_thread_t *t, int depth, int previous) {
+  int window = ASPIRATION_WINDOW;
+  int alpha = -SCORE_INFINITE;
+  int beta = SCORE_INFINITE;
+  if (g_search.features.aspiration && depth >= ASPIRATION_DEPTH &&
+      previous > -SCORE_MATE_BOUND && previous < SCORE_MATE_BOUND) {
+    alpha = previous - window;
+    beta = previous + window;
+  }
+
+  for (;;) {
+    int score = alpha_beta(t, alpha, beta, depth, 0);
+    if (should_stop(t))
+      return score;
+
+    if (score <= alpha && alpha > -SCORE_INFINITE) {
+      beta = (alpha + beta) / 2;
+      alpha = score - window;
+      if (alpha < -SCORE_INFINITE)
+        alpha = -SCORE_INFINITE;
+    } else if (score >= beta && beta < SCORE_INFINITE) {
+      beta = score + window;
+      if (beta > SCORE_INFINITE)
+        beta = SCORE_INFINITE;
+    } else {
+      return score;
+    }
+    t->stats.aspiration_researches++;
+    window *= 2;
+  }
+}
+
+// Helpers skip some iterations, staggered by thread, so the threads spread
+// over neighbouring depths instead of all searching the same tree
+static int skip_depth(const search_thread_t *t, int depth) {
+  return t->index > 0 && depth > 1 && (depth + t->index) % 3 == 0;
+}
+
+static void iterative_deepening(search_thread_t *t) {
+  const search_limits_t *limits = t->limits;
+  int max_depth = limits->depth;
+  if (max_depth <= 0 || max_depth >= MAX_PLY)
+    max_depth = MAX_PLY - 1;
+
+  int previous = 0;
+  for (int depth = 1; depth <= max_depth; depth++) {
+    if (skip_depth(t, depth))
+      continue;
+
+    uint64_t nodes_before =
+        atomic_load_explicit(&t->nodes, memory_order_relaxed);
+    int score = aspiration_search(t, depth, previous);
+    if (should_stop(t))
+      break;
+    uint64_t iteration_nodes =
+        atomic_load_explicit(&t->nodes, memory_order_relaxed) - nodes_before;
+
+    search_info_t *info = &t->info;
+    t->completed_depth = depth;
+    info->depth = depth;
+    info->score = score;
+    collect_pawn_stats(t);
+    info->stats = t->stats;
+    previous = score;
+    if (t->pv_length[0] > 0) {
+      info->pv_length = t->pv_length[0];
+      memcpy(info->pv, t->pv[0], (size_t)info->pv_length * sizeof(move_t));
+    }
+
+    if (t->index == 0) {
+      info->nodes = total_nodes(g_search.active_threads);
+      info->time_ms = time_now_ms() - t->start_time;
+      // Under a millisecond counts as one, so nps stays a rate
+      info->nps = info->nodes * 1000 /
+                  (uint64_t)(info->time_ms > 0 ? info->time_ms : 1);
+      info->hashfull = tt_hashfull(&g_search.tt);
+      if (limits->on_iteration)
+        limits->on_iteration(info);
+    }
+
+    // A forced mate found within the searched depth will not change
+    if (score >= SCORE_MATE - depth || score <= -SCORE_MATE + depth)
+      break;
+    if (atomic_load(&g_search.stop))
+      break;
+
+    // Between iterations the main thread decides whether another one is
+    // worth starting; while pondering there is no clock to watch
+    if (t->index == 0) {
+      int share = iteration_nodes > 0
+                      ? (int)(t->best_move_nodes * 1000 / iteration_nodes)
+                      : 0;
+      int64_t elapsed = time_now_ms() - atomic_load(&g_search.limits_start);
+      if (timeman_iteration_done(&g_search.time, info->pv[0], score, share,
+                                 elapsed) &&
+          !atomic_load(&g_search.pondering)) {
+        search_stop();
+        break;
+      }
+    }
+  }
+}
+
+static void *helper_main(void *arg) {
+  iterative_deepening(arg);
+  return NULL;
+}
+
+move_t search_run(const position_t *pos, const search_limits_t *limits,
+                  search_info_t *info) {
+  search_info_t last;
+  memset(&last, 0, sizeof(last));
+
+  move_list_t root_moves;
+  generate_legal_moves(pos, &root_moves);
+  if (root_moves.count == 0) {
+    last.score = position_in_check(pos) ? -SCORE_MATE : SCORE_DRAW;
+    if (info)
+      *info = last;
+    return MOVE_NONE;
+  }
+
+  int thread_count = 0;
+  int64_t start_time = time_now_ms();
+  for (int i = 0; i < g_search.thread_count; i++) {
+    search_thread_t *t = malloc(sizeof(search_thread_t));
+    if (!t)
+      break;
+
+    t->index = i;
+    t->pos = *pos;
+    nnue_reset(&t->nnue);
+    t->pos.nnue = &t->nnue;
+    pawn_table_clear(&t->pawns);
+    t->pos.pawn_table = &t->pawns;
+    t->limits = limits;
+    t->start_time = start_time;
+    atomic_init(&t->nodes, 0);
+    t->completed_depth = 0;
+    memset(&t->info, 0, sizeof(t->info));
+    memset(t->killers, 0, sizeof(t->killers));
+    t->best_move_nodes = 0;
+    history_clear(&t->history);
+    t->null_min_ply = 0;
+    memset(&t->stats, 0, sizeof(t->stats));
+    // Until an iteration completes, fall back to any legal move
+    t->info.pv[0] = root_moves.moves[0];
+    t->info.pv_length = 1;
+    g_search.threads[thread_count++] = t;
+  }
+  if (thread_count == 0) {
+    fprintf(stderr, "Out of memory for search threads\n");
+    return root_moves.moves[0];
+  }
+  g_search.active_threads = thread_count;
+
+  timeman_init(&g_search.time, limits, pos->side_to_move, root_moves.count);
+  atomic_store(&g_search.stop, 0);
+  atomic_store(&g_search.limits_start, start_time);
+  atomic_store(&g_search.pondering, limits->ponder);
+  tt_new_search(&g_search.tt);
+
+  int started = 1;
+  for (int i = 1; i < thread_count; i++) {
+    search_thread_t *t = g_search.threads[i];
+    if (pthread_create(&t->handle, NULL, helper_main, t) != 0) {
+      fprintf(stderr, "Could not start search thread %d\n", i);
+      break;
+    }
+    started++;
+  }
+
+  search_thread_t *main_thread = g_search.threads[0];
+  iterative_deepening(main_thread);
+
+  // The main thread is done, so the helpers are too
+  atomic_store(&g_search.stop, 1);
+  for (int i = 1; i < started; i++)
+    pthread_join(g_search.threads[i]->handle, NULL);
+
+  // A helper that got deeper than the main thread has the better move
+  search_thread_t *best = main_thread;
+  for (int i = 1; i < started; i++) {
+    search_thread_t *t = g_search.threads[i];
+    if (t->completed_depth > best->completed_depth)
+      best = t;
+  }
+
+  last = best->info;
+  last.nodes = total_nodes(thread_count);
+  last.time_ms = time_now_ms() - start_time;
+  last.nps =
+      last.nodes * 1000 / (uint64_t)(last.time_ms > 0 ? last.time_ms : 1);
+  last.hashfull = tt_hashfull(&g_search.tt);
+  memset(&last.stats, 0, sizeof(last.stats));
+  for (int i = 0; i < thread_count; i++) {
+    collect_pawn_stats(g_search.threads[i]);
+    search_stats_add(&last.stats, &g_search.threads[i]->stats);
+  }
+  if (info)
+    *info = last;
+
+  for (int i = 0; i < thread_count; i++) {
+    free(g_search.threads[i]);
+    g_search.threads[i] = NULL;
+  }
+  g_search.active_threads = 0;
+  return last.pv[0];
+}
@@ -0,0 +1,113 @@
+#ifndef SEARCH_H
+#define SEARCH_H
+
+#include "move.h"
+#include "position.h"
+#include <stddef.h>
+#include <stdint.h>
+
+// Deepest line the search follows
+#define MAX_PLY 128
+
+#define SEARCH_MAX_THREADS 64
+
+// Scores are centipawns from the side to move's point of view. A mate in n
+// plies scores SCORE_MATE - n, so anything beyond SCORE_MATE_BOUND is a mate.
+#define SCORE_INFINITE 32000
+#define SCORE_MATE 31000
+#define SCORE_MATE_BOUND (SCORE_MATE - MAX_PLY)
+#define SCORE_DRAW 0
+#define SCORE_NONE 32001 // No score available
+
+// Selective search techniques. Each can be switched off to measure what it
+// is worth; all are on by default.
+typedef struct {
+  int pvs;        // Principal variation search: null windows after move one
+  int aspiration; // Narrow root window around the previous iteration's score
+  int null_move;  // Null-move pruning, verified where zugzwang is likely
+  int lmr;        // Late move reductions for quiet moves
+  int futility;   // Futility and reverse futility pruning near the leaves
+} search_features_t;
+
+// How often each technique fired
+typedef struct {
+  uint64_t pvs_researches;        // Null window failed high, searched again
+  uint64_t aspiration_researches; // Root score fell outside the window
+  uint64_t null_move_tries;
+  uint64_t null_move_cutoffs;
+  uint64_t null_move_verifications; // Cutoffs checked by a normal search
+  uint64_t lmr_reductions;
+  uint64_t lmr_researches; // Reduced search beat alpha, searched again
+  uint64_t futility_prunes;
+  uint64_t reverse_futility_prunes;
+  uint64_t pawn_table_probes; // Pawn structure evaluations
+  uint64_t pawn_table_hits;
+} search_stats_t;
+
+// Add every count of stats to total
+void search_stats_add(search_stats_t *total, const search_stats_t *stats);
+
+// Outcome of the last completed iteration
+typedef struct {
+  int depth;
+  int score;
+  uint64_t nodes;
+  int64_t time_ms;
+  uint64_t nps;
+  int hashfull; // Permille of the transposition table in use
+  move_t pv[MAX_PLY];
+  int pv_length;
+  // The main thread's counts while searching; search_run's final info sums
+  // all threads
+  search_stats_t stats;
+} search_info_t;
+
+// A search ends at whichever limit comes first; 0 means no limit
+typedef struct {
+  int depth;
+  uint64_t nodes;
+  int64_t movetime; // Milliseconds
+  // Clocks, by color: time left and increment per move in milliseconds, and
+  // moves until the next time control (0 if none). The time manager turns
+  // them into a budget for this move; movetime takes precedence.
+  int64_t time[COLOR_COUNT];
+  int64_t increment[COLOR_COUNT];
+  int moves_to_go;
+  // Search the position expected after the opponent's reply while they are
+  // still thinking. The limits only apply from search_ponderhit on.
+  int ponder;
+  // Called after every completed iteration, may be NULL
+  void (*on_iteration)(const search_info_t *info);
+} search_limits_t;
+
+// Allocate the transposition table; must be called before searching
+ErrorCode search_init(size_t hash_mb);
+void search_cleanup(void);
+
+// Number of threads later searches use (Lazy SMP). With one thread a search
+// is deterministic: the same position and limits give the same result.
+void search_set_threads(int count);
+
+// Select the techniques later searches use
+void search_set_features(const search_features_t *features);
+void search_get_features(search_features_t *features);
+
+// Forget everything learned about earlier positions
+void search_new_game(void);
+
+// Search pos within limits and return the best move, MOVE_NONE if there is
+// no legal move. info (may be NULL) receives the last completed iteration.
+// Blocks until the search ends.
+move_t search_run(const position_t *pos, const search_limits_t *limits,
+                  search_info_t *info);
+
+// The opponent played the move a ponder search assumed: carry on as a
+// normal search, with the limits counted from now. Safe to call from any
+// thread.
+void search_ponderhit(void);
+
+// Make a running search return as soon as possible. Safe to call from any
+// thread.
+void search_stop(void);
+
+#endif // SEARCH_H
@@ -0,0 +1,103 @@
+#include "timeman.h"
+#include <string.h>
+
+// Kept in hand on every move for the GUI and the OS to react
+#define MOVE_OVERHEAD 50
+
+// Moves the remaining clock time is spread over when the time control does
+// not say
+#define DEFAULT_MOVES_TO_GO 30
+#define MAX_MOVES_TO_GO 50
+
+// The hard limit is at most this many times the optimum
+#define HARD_LIMIT_RATIO 5
+
+// Time factors below are in permille
+#define STABILITY_BASE 1500 // Best move just changed
+#define STABILITY_STEP 120  // Less for every iteration it has held
+#define STABILITY_MAX_ITERATIONS 6
+#define SCORE_DROP_MAX 100 // Centipawns; a bigger drop counts as this much
+#define SCORE_DROP_SCALE 5 // Permille of extra time per centipawn lost
+#define DOMINANT_SHARE 850 // Nodes spent on the best move
+#define DOMINANT_FACTOR 600
+
+static int64_t min64(int64_t a, int64_t b) { return a < b ? a : b; }
+
+void timeman_init(time_manager_t *tm, const search_limits_t *limits,
+                  int side, int legal_moves) {
+  memset(tm, 0, sizeof(*tm));
+  tm->single_move = legal_moves == 1;
+
+  if (limits->movetime > 0) {
+    tm->optimum = tm->soft = tm->hard = limits->movetime;
+    tm->fixed = 1;
+    return;
+  }
+  if (limits->time[side] <= 0)
+    return;
+
+  int64_t available = limits->time[side] - MOVE_OVERHEAD;
+  if (available < 1)
+    available = 1;
+
+  int moves_to_go = limits->moves_to_go > 0 ? limits->moves_to_go
+                                            : DEFAULT_MOVES_TO_GO;
+  if (moves_to_go > MAX_MOVES_TO_GO)
+    moves_to_go = MAX_MOVES_TO_GO;
+
+  // Before the time control the last move may use nearly all that is left;
+  // otherwise keep a reserve for the moves after this one
+  int64_t ceiling = moves_to_go == 1 ? available * 9 / 10 : available * 4 / 5;
+  int64_t optimum =
+      available / moves_to_go + limits->increment[side] * 3 / 4;
+
+  tm->hard = min64(optimum * HARD_LIMIT_RATIO, ceiling);
+  if (tm->hard < 1)
+    tm->hard = 1;
+  tm->optimum = min64(optimum, tm->hard);
+  tm->soft = tm->optimum;
+}
+
+int timeman_iteration_done(time_manager_t *tm, move_t best, int score,
+                           int best_move_share, int64_t elapsed) {
+  int first = tm->best_move == MOVE_NONE;
+
+  if (best == tm->best_move) {
+    tm->stable_iterations++;
+  } else {
+    tm->stable_iterations = 0;
+    tm->best_move = best;
+  }
+
+  if (tm->optimum == 0 || tm->fixed) {
+    tm->previous_score = score;
+    return 0;
+  }
+  if (tm->single_move)
+    return 1;
+
+  // A best move that keeps changing needs more time, a settled one less
+  int stable = tm->stable_iterations < STABILITY_MAX_ITERATIONS
+                   ? tm->stable_iterations
+                   : STABILITY_MAX_ITERATIONS;
+  int64_t factor = STABILITY_BASE - STABILITY_STEP * stable;
+
+  // So does a score that fell since the last iteration
+  int drop = first ? 0 : tm->previous_score - score;
+  if (drop > 0) {
+    if (drop > SCORE_DROP_MAX)
+      drop = SCORE_DROP_MAX;
+    factor = factor * (1000 + drop * SCORE_DROP_SCALE) / 1000;
+  }
+  tm->previous_score = score;
+
+  // One move taking nearly all the effort is not going to be overturned
+  if (best_move_share >= DOMINANT_SHARE && stable > 0)
+    factor = factor * DOMINANT_FACTOR / 1000;
+
+  tm->soft = min64(tm->optimum * factor / 1000, tm->hard);
+
+  // The next iteration takes about as long as all before it, so only start
+  // one that can finish in time
+  return elapsed >= tm->soft / 2;
+}
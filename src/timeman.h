@@ -0,0 +1,39 @@
+#ifndef TIMEMAN_H
+#define TIMEMAN_H
+
+#include "move.h"
+#include "search.h"
+#include <stdint.h>
+
+// Time set aside for one move, in milliseconds from when the limits start
+// to count. The search aims for the soft limit, which is stretched or
+// shrunk between iterations as the search goes; it never passes the hard
+// limit.
+typedef struct {
+  int64_t optimum; // Soft limit before adjustments, 0 = no time limit
+  int64_t soft;
+  int64_t hard;
+  int fixed; // movetime: use exactly the hard limit
+  int single_move; // Only one legal move, nothing to think about
+  move_t best_move;
+  int stable_iterations; // Iterations the best move has not changed
+  int previous_score;
+} time_manager_t;
+
+// Work out the limits for side to move from limits' clock or movetime
+void timeman_init(time_manager_t *tm, const search_limits_t *limits,
+                  int side, int legal_moves);
+
+// Take in a completed iteration: its best move, score and the permille of
+// the iteration's nodes spent on the best move. Returns 1 if, with elapsed
+// milliseconds gone, another iteration should not be started.
+int timeman_iteration_done(time_manager_t *tm, move_t best, int score,
+                           int best_move_share, int64_t elapsed);
+
+// Whether the hard limit has passed; called only every few thousand nodes
+static inline int timeman_out_of_time(const time_manager_t *tm,
+                                      int64_t elapsed) {
+  return tm->hard > 0 && elapsed >= tm->hard;
+}
+
+#endif // TIMEMAN_H
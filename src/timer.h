@@ -0,0 +1,22 @@
+#ifndef TIMER_H
+#define TIMER_H
+
+#include <stdint.h>
+#include <time.h>
+
+// clock_gettime is POSIX, hidden by -std=c11: files using this header define
+// _POSIX_C_SOURCE 199309L (or _DEFAULT_SOURCE) before any include
+#ifndef CLOCK_MONOTONIC
+#error "timer.h needs _POSIX_C_SOURCE 199309L defined before any include"
+#endif
+
+// Milliseconds since an arbitrary fixed point, for measuring intervals. The
+// monotonic clock is used so that setting the system clock cannot make an
+// interval negative or huge.
+static inline int64_t time_now_ms(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+#endif // TIMER_H
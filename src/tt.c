@@ -0,0 +1,182 @@
+// mmap and madvise are POSIX/BSD extensions hidden by -std=c11
+#define _DEFAULT_SOURCE
+#include "tt.h"
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+// An entry's data packed into 64 bits:
+//   bits  0-15  move
+//   bits 16-31  score (signed)
+//   bits 32-47  static evaluation (signed)
+//   bits 48-55  depth + TT_DEPTH_OFFSET
+//   bits 56-57  bound
+//   bits 58-63  generation
+// A stored entry always has a bound, so data 0 marks an empty slot.
+#define GENERATION_MASK 63
+
+static inline uint64_t pack(move_t move, int score, int eval, int depth,
+                            int bound, int generation) {
+  return (uint64_t)move | ((uint64_t)(uint16_t)score << 16) |
+         ((uint64_t)(uint16_t)eval << 32) |
+         ((uint64_t)(uint8_t)(depth + TT_DEPTH_OFFSET) << 48) |
+         ((uint64_t)bound << 56) | ((uint64_t)generation << 58);
+}
+
+static inline int data_depth(uint64_t data) {
+  return (int)((data >> 48) & 0xff) - TT_DEPTH_OFFSET;
+}
+static inline int data_bound(uint64_t data) { return (data >> 56) & 3; }
+static inline int data_generation(uint64_t data) { return data >> 58; }
+
+ErrorCode tt_init(tt_t *tt, size_t size_mb, int huge_pages) {
+  if (!tt)
+    return ERROR_INVALID_INPUT;
+
+  memset(tt, 0, sizeof(*tt));
+
+  size_t bytes = size_mb << 20;
+  size_t count = 1;
+  while (count * 2 * sizeof(tt_bucket_t) <= bytes)
+    count *= 2;
+  bytes = count * sizeof(tt_bucket_t);
+
+#ifdef __linux__
+  if (huge_pages) {
+    void *memory = mmap(NULL, bytes, PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (memory != MAP_FAILED) {
+      // Transparent huge pages; harmless if the kernel declines
+      madvise(memory, bytes, MADV_HUGEPAGE);
+      tt->buckets = memory;
+      tt->huge_pages = 1;
+    }
+  }
+#else
+  (void)huge_pages;
+#endif
+
+  if (!tt->buckets) {
+    tt->buckets = aligned_alloc(sizeof(tt_bucket_t), bytes);
+    if (!tt->buckets)
+      return ERROR_MEMORY_ALLOC;
+  }
+
+  tt->bucket_count = count;
+  tt->bytes = bytes;
+  tt_clear(tt);
+  return ERROR_NONE;
+}
+
+void tt_free(tt_t *tt) {
+  if (!tt || !tt->buckets)
+    return;
+
+#ifdef __linux__
+  if (tt->huge_pages) {
+    munmap(tt->buckets, tt->bytes);
+  } else {
+    free(tt->buckets);
+  }
+#else
+  free(tt->buckets);
+#endif
+  tt->buckets = NULL;
+  tt->bucket_count = 0;
+}
+
+void tt_clear(tt_t *tt) {
+  // Also commits every page up front rather than during the first search
+  memset(tt->buckets, 0, tt->bytes);
+  tt->generation = 0;
+}
+
+void tt_new_search(tt_t *tt) {
+  tt->generation = (tt->generation + 1) & GENERATION_MASK;
+}
+
+int tt_probe(const tt_t *tt, uint64_t key, tt_data_t *out) {
+  tt_bucket_t *bucket = tt_bucket(tt, key);
+
+  for (int i = 0; i < TT_BUCKET_SIZE; i++) {
+    tt_entry_t *entry = &bucket->entries[i];
+    uint64_t data = atomic_load_explicit(&entry->data, memory_order_relaxed);
+    uint64_t check = atomic_load_explicit(&entry->key, memory_order_relaxed);
+
+    if (data && (check ^ data) == key) {
+      out->move = (move_t)(data & 0xffff);
+      out->score = (int16_t)(data >> 16);
+      out->eval = (int16_t)(data >> 32);
+      out->depth = data_depth(data);
+      out->bound = data_bound(data);
+      return 1;
+    }
+  }
+  return 0;
+}
+
+void tt_store(tt_t *tt, uint64_t key, move_t move, int score, int eval,
+              int depth, int bound) {
+  tt_bucket_t *bucket = tt_bucket(tt, key);
+  tt_entry_t *replace = NULL;
+  uint64_t replace_data = 0;
+  int worst = 0;
+
+  for (int i = 0; i < TT_BUCKET_SIZE; i++) {
+    tt_entry_t *entry = &bucket->entries[i];
+    uint64_t data = atomic_load_explicit(&entry->data, memory_order_relaxed);
+    uint64_t check = atomic_load_explicit(&entry->key, memory_order_relaxed);
+
+    // Same position (or a free slot): always overwrite
+    if (!data || (check ^ data) == key) {
+      replace = entry;
+      replace_data = data;
+      break;
+    }
+
+    // Otherwise evict the shallowest entry, counting every search of age as
+    // a few plies of depth
+    int age = (tt->generation - data_generation(data)) & GENERATION_MASK;
+    int value = data_depth(data) - 4 * age;
+    if (!replace || value < worst) {
+      replace = entry;
+      replace_data = 0;
+      worst = value;
+    }
+  }
+
+  // Keep a shallow result of the same position from losing its move, and
+  // keep a much deeper exact result from being overwritten by a bound
+  if (replace_data) {
+    if (move == MOVE_NONE)
+      move = (move_t)(replace_data & 0xffff);
+    if (bound != BOUND_EXACT && data_bound(replace_data) == BOUND_EXACT &&
+        data_depth(replace_data) > depth + 2 &&
+        data_generation(replace_data) == tt->generation)
+      return;
+  }
+
+  uint64_t data = pack(move, score, eval, depth, bound, tt->generation);
+  atomic_store_explicit(&replace->key, key ^ data, memory_order_relaxed);
+  atomic_store_explicit(&replace->data, data, memory_order_relaxed);
+}
+
+int tt_hashfull(const tt_t *tt) {
+  int buckets = 1000 / TT_BUCKET_SIZE;
+  if ((size_t)buckets > tt->bucket_count)
+    buckets = (int)tt->bucket_count;
+
+  int used = 0;
+  for (int b = 0; b < buckets; b++) {
+    for (int i = 0; i < TT_BUCKET_SIZE; i++) {
+      uint64_t data = atomic_load_explicit(&tt->buckets[b].entries[i].data,
+                                           memory_order_relaxed);
+      if (data && data_generation(data) == tt->generation)
+        used++;
+    }
+  }
+  return used * 1000 / (buckets * TT_BUCKET_SIZE);
+}
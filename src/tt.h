@@ -0,0 +1,80 @@
+#ifndef TT_H
+#define TT_H
+
+#include "config.h"
+#include "move.h"
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// What a stored score says about the true score of the position
+enum { BOUND_NONE = 0, BOUND_UPPER = 1, BOUND_LOWER = 2, BOUND_EXACT = 3 };
+
+// Stored depths may be slightly negative (quiescence search)
+#define TT_DEPTH_OFFSET 8
+
+#define TT_BUCKET_SIZE 4
+
+// One table slot. Search threads read and write entries without locks: key
+// holds the position key XORed with data, so a slot torn by two concurrent
+// writers fails the key check and reads as a miss instead of as wrong data.
+typedef struct {
+  _Atomic uint64_t key;  // Position key ^ data
+  _Atomic uint64_t data; // Packed, see tt.c
+} tt_entry_t;
+
+// Four entries fill one 64-byte cache line, so a probe touches one line
+typedef struct {
+  tt_entry_t entries[TT_BUCKET_SIZE];
+} tt_bucket_t;
+
+// Unpacked contents of an entry
+typedef struct {
+  move_t move;
+  int score;
+  int eval;  // Static evaluation of the position
+  int depth;
+  int bound; // BOUND_*
+} tt_data_t;
+
+typedef struct {
+  tt_bucket_t *buckets;
+  size_t bucket_count; // Always a power of two
+  size_t bytes;        // Size of the allocation
+  int huge_pages;      // Whether buckets came from mmap
+  uint8_t generation;  // Bumped for each new search, ages old entries
+} tt_t;
+
+// Allocate a table of at most size_mb megabytes (rounded down to a power of
+// two buckets). With huge_pages set, ask the OS to back it with huge pages
+// where supported, which cuts TLB misses on large tables.
+ErrorCode tt_init(tt_t *tt, size_t size_mb, int huge_pages);
+void tt_free(tt_t *tt);
+
+// Forget every entry, e.g. between games
+void tt_clear(tt_t *tt);
+
+// Call at the start of each search so entries from older searches are
+// replaced first
+void tt_new_search(tt_t *tt);
+
+// Look up key; returns 1 and fills out on a hit
+int tt_probe(const tt_t *tt, uint64_t key, tt_data_t *out);
+
+void tt_store(tt_t *tt, uint64_t key, move_t move, int score, int eval,
+              int depth, int bound);
+
+// Permille of the table used by the current search, sampled from the first
+// buckets (the UCI "hashfull" figure)
+int tt_hashfull(const tt_t *tt);
+
+static inline tt_bucket_t *tt_bucket(const tt_t *tt, uint64_t key) {
+  return &tt->buckets[key & (tt->bucket_count - 1)];
+}
+
+// Start loading the bucket of key into cache, before it is needed
+static inline void tt_prefetch(const tt_t *tt, uint64_t key) {
+  __builtin_prefetch(tt_bucket(tt, key));
+}
+
+#endif // TT_H
@@ -0,0 +1,569 @@
+// mmap and madvise are POSIX/BSD extensions hidden by -std=c11
+#define _DEFAULT_SOURCE
+#include "tune.h"
+#include "params.h"
+#include "pawns.h"
+#include "position.h"
+#include "psqt.h"
+#include "timer.h"
+#include <fcntl.h>
+#include <inttypes.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Converted position files: a header, then fixed-size records in the byte
+// order of the machine that converted them, so they can be used straight
+// from the mapping
+#define TUNE_MAGIC "CHTD"
+#define TUNE_VERSION 1
+#define TARGET_MAX 65535
+
+typedef struct {
+  char magic[4];
+  uint32_t version;
+  uint64_t count;
+} tune_header_t;
+
+typedef struct {
+  uint64_t occupied;
+  // 4 bits per occupied square, lowest square first:
+  // type | (color - WHITE) << 3
+  uint8_t pieces[16];
+  uint16_t target; // Label as White's expected score, TARGET_MAX for a win
+  uint8_t phase;   // Game phase, at most PHASE_MAX
+  uint8_t reserved[5];
+} tune_record_t;
+
+_Static_assert(sizeof(tune_record_t) == 32, "tune records must stay packed");
+
+// Score labels are turned into expected results with a fixed scale, so they
+// can share the file format with game results
+#define SCORE_LABEL_SCALE 400.0
+
+// Adam step parameters
+#define ADAM_BETA1 0.9
+#define ADAM_BETA2 0.999
+#define ADAM_EPSILON 1e-8
+
+#define PROGRESS_INTERVAL 10 // Epochs between progress lines
+
+// Pieces plus the pawn terms
+#define MAX_FEATURES 80
+
+/// Conversion
+static int parse_label(char *token, double *target) {
+  // Strip EPD decoration such as "1-0";
+  size_t length = strlen(token);
+  while (length > 0 && (token[length - 1] == ';' || token[length - 1] == '"'))
+    token[--length] = '\0';
+  if (*token == '"')
+    token++;
+
+  if (strcmp(token, "1-0") == 0) {
+    *target = 1.0;
+  } else if (strcmp(token, "0-1") == 0) {
+    *target = 0.0;
+  } else if (strcmp(token, "1/2-1/2") == 0) {
+    *target = 0.5;
+  } else if (*token == '[') {
+    char *end;
+    *target = strtod(token + 1, &end);
+    if (end == token + 1 || *end != ']' || *target < 0.0 || *target > 1.0)
+      return 0;
+  } else {
+    char *end;
+    long score = strtol(token, &end, 10);
+    if (end == token || *end != '\0')
+      return 0;
+    *target = 1.0 / (1.0 + pow(10.0, -(double)score / SCORE_LABEL_SCALE));
+  }
+  return 1;
+}
+
+static int encode_record(const position_t *pos, double target,
+                         tune_record_t *record) {
+  const board_t *board = &pos->board;
+  memset(record, 0, sizeof(*record));
+  if (popcount(board->occupied[NONE]) > 32)
+    return 0;
+
+  record->occupied = board->occupied[NONE];
+  bitboard_t occupied = board->occupied[NONE];
+  for (int i = 0; occupied; i++) {
+    piece_t piece = piece_on(board, pop_lsb(&occupied));
+    int code = type_of(piece) | ((color_of(piece) - WHITE) << 3);
+    record->pieces[i / 2] |= (uint8_t)(code << (4 * (i & 1)));
+  }
+  record->target = (uint16_t)lround(target * TARGET_MAX);
+  record->phase =
+      (uint8_t)(board->phase < PHASE_MAX ? board->phase : PHASE_MAX);
+  return 1;
+}
+
+ErrorCode tune_convert(const char *text_path, const char *binary_path) {
+  FILE *in = fopen(text_path, "r");
+  if (!in) {
+    fprintf(stderr, "Unable to open %s\n", text_path);
+    return ERROR_FILE_LOAD;
+  }
+  FILE *out = fopen(binary_path, "wb");
+  position_t *pos = malloc(sizeof(position_t));
+  if (!out || !pos) {
+    fprintf(stderr, "Unable to write %s\n", binary_path);
+    if (out)
+      fclose(out);
+    free(pos);
+    fclose(in);
+    return out ? ERROR_MEMORY_ALLOC : ERROR_FILE_LOAD;
+  }
+
+  tune_header_t header = {{0}, TUNE_VERSION, 0};
+  memcpy(header.magic, TUNE_MAGIC, 4);
+  int ok = fwrite(&header, sizeof(header), 1, out) == 1;
+  uint64_t skipped = 0;
+  char line[512];
+  while (ok && fgets(line, sizeof(line), in)) {
+    // The label is the last word, the FEN everything before it
+    size_t length = strcspn(line, "\r\n");
+    while (length > 0 && line[length - 1] == ' ')
+      length--;
+    line[length] = '\0';
+    char *label = strrchr(line, ' ');
+    double target;
+    tune_record_t record;
+    if (!label || !parse_label(label + 1, &target)) {
+      skipped += length > 0;
+      continue;
+    }
+    *label = '\0';
+    if (position_set_fen(pos, line) != ERROR_NONE ||
+        !encode_record(pos, target, &record)) {
+      skipped++;
+      continue;
+    }
+    ok = fwrite(&record, sizeof(record), 1, out) == 1;
+    header.count++;
+  }
+
+  if (ok) {
+    ok = fseek(out, 0, SEEK_SET) == 0 &&
+         fwrite(&header, sizeof(header), 1, out) == 1;
+  }
+  ok = (fclose(out) == 0) && ok;
+  fclose(in);
+  free(pos);
+  if (!ok) {
+    fprintf(stderr, "Unable to write %s\n", binary_path);
+    return ERROR_FILE_LOAD;
+  }
+
+  printf("Converted %" PRIu64 " positions to %s (%" PRIu64 " lines skipped)\n",
+         header.count, binary_path, skipped);
+  return ERROR_NONE;
+}
+
+int tune_is_binary(const char *path) {
+  FILE *file = fopen(path, "rb");
+  if (!file)
+    return 0;
+  tune_header_t header;
+  int binary = fread(&header, sizeof(header), 1, file) == 1 &&
+               memcmp(header.magic, TUNE_MAGIC, 4) == 0;
+  fclose(file);
+  return binary;
+}
+
+/// Features
+// How often a term counts for White minus how often it counts for Black
+typedef struct {
+  uint16_t term;
+  int16_t count;
+} feature_t;
+
+static inline void add_feature(feature_t *features, int *n, int term,
+                               int count) {
+  if (count) {
+    features[*n].term = (uint16_t)term;
+    features[*n].count = (int16_t)count;
+    (*n)++;
+  }
+}
+
+static int extract_features(const tune_record_t *record, feature_t *features) {
+  // pawns_count_terms only reads the bitboards
+  board_t board;
+  memset(board.pieces, 0, sizeof(board.pieces));
+
+  int n = 0;
+  bitboard_t occupied = record->occupied;
+  for (int i = 0; occupied; i++) {
+    int square = pop_lsb(&occupied);
+    int code = (record->pieces[i / 2] >> (4 * (i & 1))) & 15;
+    int type = code & 7;
+    int color = WHITE + (code >> 3);
+    int sign = (color == WHITE) ? 1 : -1;
+    board.pieces[color][type] |= square_bb(square);
+
+    if (type != KING)
+      add_feature(features, &n, PARAM_PIECE_VALUE + type - PAWN, sign);
+    // Black reads the square tables upside down
+    int oriented = (color == WHITE) ? square : square ^ 56;
+    add_feature(features, &n,
+                PARAM_SQUARE_BONUS + (type - PAWN) * SQUARE_COUNT + oriented,
+                sign);
+  }
+
+  pawn_terms_t white, black;
+  pawns_count_terms(&board, WHITE, &white);
+  pawns_count_terms(&board, BLACK, &black);
+  add_feature(features, &n, PARAM_PAWN_DOUBLED, white.doubled - black.doubled);
+  add_feature(features, &n, PARAM_PAWN_ISOLATED,
+              white.isolated - black.isolated);
+  add_feature(features, &n, PARAM_PAWN_BACKWARD,
+              white.backward - black.backward);
+  for (int rank = 1; rank < 7; rank++) {
+    add_feature(features, &n, PARAM_PAWN_PASSED + rank - 1,
+                white.passed[rank] - black.passed[rank]);
+  }
+  for (int i = 0; i < 2; i++) {
+    add_feature(features, &n, PARAM_PAWN_SHELTER + i,
+                white.shelter[i] - black.shelter[i]);
+  }
+  return n;
+}
+
+/// Parallel passes
+// Each thread's share of the positions and its private sums
+typedef struct {
+  uint64_t begin;
+  uint64_t end;
+  double error;
+  double gradient[PARAM_COUNT][2];
+} tune_worker_t;
+
+static struct {
+  const tune_record_t *records;
+  double weights[PARAM_COUNT][2]; // Current parameters, [term][PHASE_*]
+  double scale;                   // K * ln(10) / 400
+  int with_gradient;
+  tune_worker_t *workers;
+  int worker_count;
+  // Workers sleep until generation changes, then run one pass over their
+  // share and count themselves in finished
+  pthread_mutex_t lock;
+  pthread_cond_t wake;
+  pthread_cond_t done;
+  uint64_t generation;
+  int finished;
+  int quit;
+} g_tune;
+
+// White's evaluation with the current weights; the features of the record
+// are left in features
+static double evaluate_record(const tune_record_t *record,
+                              feature_t *features, int *count) {
+  *count = extract_features(record, features);
+  double mg = 0.0, eg = 0.0;
+  for (int i = 0; i < *count; i++) {
+    mg += features[i].count * g_tune.weights[features[i].term][PHASE_MG];
+    eg += features[i].count * g_tune.weights[features[i].term][PHASE_EG];
+  }
+  return (mg * record->phase + eg * (PHASE_MAX - record->phase)) / PHASE_MAX;
+}
+
+static void run_share(tune_worker_t *worker) {
+  feature_t features[MAX_FEATURES];
+  int count;
+  double error = 0.0;
+  if (g_tune.with_gradient)
+    memset(worker->gradient, 0, sizeof(worker->gradient));
+
+  for (uint64_t i = worker->begin; i < worker->end; i++) {
+    const tune_record_t *record = &g_tune.records[i];
+    double eval = evaluate_record(record, features, &count);
+    double sigmoid = 1.0 / (1.0 + exp(-g_tune.scale * eval));
+    double difference = record->target / (double)TARGET_MAX - sigmoid;
+    error += difference * difference;
+    if (!g_tune.with_gradient)
+      continue;
+
+    // Derivative of the squared difference with respect to the evaluation,
+    // split between the middlegame and endgame weights by the phase
+    double slope =
+        -2.0 * difference * sigmoid * (1.0 - sigmoid) * g_tune.scale;
+    double mg = slope * record->phase / PHASE_MAX;
+    double eg = slope * (PHASE_MAX - record->phase) / PHASE_MAX;
+    for (int j = 0; j < count; j++) {
+      worker->gradient[features[j].term][PHASE_MG] += mg * features[j].count;
+      worker->gradient[features[j].term][PHASE_EG] += eg * features[j].count;
+    }
+  }
+  worker->error = error;
+}
+
+static void *worker_main(void *arg) {
+  tune_worker_t *worker = arg;
+  uint64_t seen = 0;
+
+  pthread_mutex_lock(&g_tune.lock);
+  for (;;) {
+    while (g_tune.generation == seen && !g_tune.quit)
+      pthread_cond_wait(&g_tune.wake, &g_tune.lock);
+    if (g_tune.quit)
+      break;
+    seen = g_tune.generation;
+    pthread_mutex_unlock(&g_tune.lock);
+
+    run_share(worker);
+
+    pthread_mutex_lock(&g_tune.lock);
+    g_tune.finished++;
+    pthread_cond_signal(&g_tune.done);
+  }
+  pthread_mutex_unlock(&g_tune.lock);
+  return NULL;
+}
+
+// One pass over all positions on every thread, the calling thread included.
+// Returns the mean squared error; with_gradient also leaves its gradient,
+// summed over the threads, in gradient.
+static double run_pass(uint64_t count, int with_gradient,
+                       double gradient[PARAM_COUNT][2]) {
+  pthread_mutex_lock(&g_tune.lock);
+  g_tune.with_gradient = with_gradient;
+  g_tune.finished = 0;
+  g_tune.generation++;
+  pthread_cond_broadcast(&g_tune.wake);
+  pthread_mutex_unlock(&g_tune.lock);
+
+  run_share(&g_tune.workers[0]);
+
+  pthread_mutex_lock(&g_tune.lock);
+  while (g_tune.finished < g_tune.worker_count - 1)
+    pthread_cond_wait(&g_tune.done, &g_tune.lock);
+  pthread_mutex_unlock(&g_tune.lock);
+
+  double error = 0.0;
+  if (with_gradient)
+    memset(gradient, 0, sizeof(double) * PARAM_COUNT * 2);
+  for (int i = 0; i < g_tune.worker_count; i++) {
+    const tune_worker_t *worker = &g_tune.workers[i];
+    error += worker->error;
+    if (!with_gradient)
+      continue;
+    for (int term = 0; term < PARAM_COUNT; term++) {
+      gradient[term][PHASE_MG] += worker->gradient[term][PHASE_MG] / count;
+      gradient[term][PHASE_EG] += worker->gradient[term][PHASE_EG] / count;
+    }
+  }
+  return error / count;
+}
+
+static double error_at(uint64_t count, double k) {
+  g_tune.scale = k * log(10.0) / 400.0;
+  return run_pass(count, 0, NULL);
+}
+
+// K such that the current evaluation best predicts the labels, by golden
+// section search; the error is close to convex in K
+static double fit_k(uint64_t count) {
+  const double ratio = (sqrt(5.0) - 1.0) / 2.0;
+  double low = 0.01, high = 4.0;
+  double a = high - ratio * (high - low), b = low + ratio * (high - low);
+  double error_a = error_at(count, a), error_b = error_at(count, b);
+  for (int i = 0; i < 24; i++) {
+    if (error_a < error_b) {
+      high = b;
+      b = a;
+      error_b = error_a;
+      a = high - ratio * (high - low);
+      error_a = error_at(count, a);
+    } else {
+      low = a;
+      a = b;
+      error_a = error_b;
+      b = low + ratio * (high - low);
+      error_b = error_at(count, b);
+    }
+  }
+  return (low + high) / 2.0;
+}
+
+/// Driver
+static ErrorCode map_records(const char *path, void **base, size_t *size,
+                             uint64_t *count) {
+  int fd = open(path, O_RDONLY);
+  if (fd < 0) {
+    fprintf(stderr, "Unable to open %s\n", path);
+    return ERROR_FILE_LOAD;
+  }
+  struct stat info;
+  if (fstat(fd, &info) != 0 || (size_t)info.st_size < sizeof(tune_header_t)) {
+    close(fd);
+    fprintf(stderr, "%s is not a converted position file\n", path);
+    return ERROR_FILE_LOAD;
+  }
+
+  *size = (size_t)info.st_size;
+  *base = mmap(NULL, *size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (*base == MAP_FAILED) {
+    fprintf(stderr, "Unable to map %s\n", path);
+    return ERROR_FILE_LOAD;
+  }
+
+  const tune_header_t *header = *base;
+  if (memcmp(header->magic, TUNE_MAGIC, 4) != 0 ||
+      header->version != TUNE_VERSION ||
+      *size != sizeof(tune_header_t) + header->count * sizeof(tune_record_t)) {
+    fprintf(stderr, "%s is not a converted position file\n", path);
+    munmap(*base, *size);
+    return ERROR_FILE_LOAD;
+  }
+  *count = header->count;
+#ifdef __linux__
+  // Every pass reads the file front to back
+  madvise(*base, *size, MADV_SEQUENTIAL);
+#endif
+  return ERROR_NONE;
+}
+
+ErrorCode tune_run(const char *binary_path, const tune_options_t *options) {
+  void *base;
+  size_t size;
+  uint64_t count;
+  ErrorCode result = map_records(binary_path, &base, &size, &count);
+  if (result != ERROR_NONE)
+    return result;
+  if (count == 0) {
+    fprintf(stderr, "%s holds no positions\n", binary_path);
+    munmap(base, size);
+    return ERROR_INVALID_INPUT;
+  }
+
+  int threads = options->threads;
+  if (threads < 1)
+    threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+  if (threads < 1)
+    threads = 1;
+  if (threads > TUNE_MAX_THREADS)
+    threads = TUNE_MAX_THREADS;
+
+  // All buffers are set up here, once; the passes only read the mapping
+  double (*state)[PARAM_COUNT][2] = calloc(4, sizeof(*state));
+  g_tune.workers = calloc((size_t)threads, sizeof(tune_worker_t));
+  if (!state || !g_tune.workers) {
+    fprintf(stderr, "Out of memory\n");
+    free(state);
+    free(g_tune.workers);
+    munmap(base, size);
+    return ERROR_MEMORY_ALLOC;
+  }
+  double(*gradient)[2] = state[0];
+  double(*momentum)[2] = state[1];
+  double(*velocity)[2] = state[2];
+  int tuned[PARAM_COUNT][2];
+
+  for (int term = 0; term < PARAM_COUNT; term++) {
+    for (int phase = PHASE_MG; phase <= PHASE_EG; phase++) {
+      int *value = param_value(term, phase);
+      g_tune.weights[term][phase] = value ? *value : 0.0;
+      tuned[term][phase] = value != NULL;
+    }
+  }
+
+  g_tune.records =
+      (const tune_record_t *)((const char *)base + sizeof(tune_header_t));
+  g_tune.generation = 0;
+  g_tune.quit = 0;
+  pthread_mutex_init(&g_tune.lock, NULL);
+  pthread_cond_init(&g_tune.wake, NULL);
+  pthread_cond_init(&g_tune.done, NULL);
+
+  // The calling thread works too, so only threads - 1 are started
+  pthread_t handles[TUNE_MAX_THREADS];
+  int started = 1;
+  for (int i = 1; i < threads; i++) {
+    if (pthread_create(&handles[i], NULL, worker_main, &g_tune.workers[i]) !=
+        0) {
+      fprintf(stderr, "Could not start tuning thread %d\n", i);
+      break;
+    }
+    started++;
+  }
+  g_tune.worker_count = started;
+  for (int i = 0; i < started; i++) {
+    g_tune.workers[i].begin = count * (uint64_t)i / (uint64_t)started;
+    g_tune.workers[i].end = count * (uint64_t)(i + 1) / (uint64_t)started;
+  }
+
+  int64_t start = time_now_ms();
+  double k = options->k > 0.0 ? options->k : fit_k(count);
+  double error = error_at(count, k);
+  printf("Positions: %" PRIu64 ", threads: %d, K: %.4f, error: %.6f\n",
+         count, started, k, error);
+
+  for (int epoch = 1; epoch <= options->epochs; epoch++) {
+    error = run_pass(count, 1, gradient);
+
+    // Adam: steps of about options->rate, scaled per parameter by how
+    // steady its gradient has been
+    double correction1 = 1.0 - pow(ADAM_BETA1, epoch);
+    double correction2 = 1.0 - pow(ADAM_BETA2, epoch);
+    for (int term = 0; term < PARAM_COUNT; term++) {
+      for (int phase = PHASE_MG; phase <= PHASE_EG; phase++) {
+        if (!tuned[term][phase])
+          continue;
+        double g = gradient[term][phase];
+        momentum[term][phase] =
+            ADAM_BETA1 * momentum[term][phase] + (1.0 - ADAM_BETA1) * g;
+        velocity[term][phase] =
+            ADAM_BETA2 * velocity[term][phase] + (1.0 - ADAM_BETA2) * g * g;
+        g_tune.weights[term][phase] -=
+            options->rate * (momentum[term][phase] / correction1) /
+            (sqrt(velocity[term][phase] / correction2) + ADAM_EPSILON);
+      }
+    }
+
+    if (epoch % PROGRESS_INTERVAL == 0 || epoch == options->epochs) {
+      printf("Epoch %d: error %.6f, %.1f s\n", epoch, error,
+             (time_now_ms() - start) / 1000.0);
+      fflush(stdout);
+    }
+  }
+
+  // The engine uses whole centipawns; report the error it will see
+  for (int term = 0; term < PARAM_COUNT; term++) {
+    for (int phase = PHASE_MG; phase <= PHASE_EG; phase++) {
+      if (!tuned[term][phase])
+        continue;
+      int value = (int)lround(g_tune.weights[term][phase]);
+      *param_value(term, phase) = value;
+      g_tune.weights[term][phase] = value;
+    }
+  }
+  psqt_rebuild();
+  printf("Final error: %.6f\n", error_at(count, k));
+
+  pthread_mutex_lock(&g_tune.lock);
+  g_tune.quit = 1;
+  pthread_cond_broadcast(&g_tune.wake);
+  pthread_mutex_unlock(&g_tune.lock);
+  for (int i = 1; i < started; i++)
+    pthread_join(handles[i], NULL);
+  pthread_cond_destroy(&g_tune.done);
+  pthread_cond_destroy(&g_tune.wake);
+  pthread_mutex_destroy(&g_tune.lock);
+
+  free(state);
+  free(g_tune.workers);
+  g_tune.workers = NULL;
+  munmap(base, size);
+  return params_save(options->output);
+}
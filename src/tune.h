@@ -0,0 +1,33 @@
+#ifndef TUNE_H
+#define TUNE_H
+
+#include "config.h"
+
+#define TUNE_MAX_THREADS 64
+
+typedef struct {
+  int threads; // Threads the positions are split across, 0 for every core
+  int epochs;  // Passes over the data
+  double rate; // Step size, roughly centipawns per epoch
+  double k;    // Scale from evaluation to expected result, 0 fits it first
+  const char *output; // Parameter file written at the end
+} tune_options_t;
+
+// Convert labelled positions from text to the binary form tune_run maps.
+// Each line is a FEN followed by a label: a game result from White's point
+// of view ("1-0", "0-1", "1/2-1/2", or [1.0], [0.5], [0.0]) or an
+// evaluation in centipawns for White. Lines that do not parse are skipped.
+ErrorCode tune_convert(const char *text_path, const char *binary_path);
+
+// Whether path holds converted positions
+int tune_is_binary(const char *path);
+
+// Texel tuning: fit the evaluation parameters (see params.h) to the
+// positions in binary_path by gradient descent on the squared difference
+// between each label and the logistic of the evaluation, then write them to
+// options->output. The file is memory-mapped and each thread accumulates
+// the error and gradient of its share of the positions in its own buffers,
+// so no memory is allocated per position or per epoch.
+ErrorCode tune_run(const char *binary_path, const tune_options_t *options);
+
+#endif // TUNE_H
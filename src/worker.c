@@ -0,0 +1,270 @@
+#include "worker.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <string.h>
+
+#define WORKER_QUEUE_SIZE 8
+
+// Mailbox slot indices fit in two bits; this bit marks an unread result
+#define MAILBOX_FRESH 4
+
+enum { WORKER_CMD_SEARCH, WORKER_CMD_NEW_GAME, WORKER_CMD_QUIT };
+
+typedef struct {
+  int type;
+  uint32_t id;
+  unsigned stop_generation; // worker_stop calls made before it was queued
+  search_limits_t limits;
+  position_t position;
+} worker_command_t;
+
+static struct {
+  pthread_t thread;
+  int running;
+
+  // Command queue, a ring buffer guarded by lock
+  pthread_mutex_t lock;
+  pthread_cond_t wake;
+  worker_command_t queue[WORKER_QUEUE_SIZE];
+  int head;
+  int count;
+  uint32_t next_id;
+
+  // Bumped by every worker_stop; a search queued before the current value
+  // has been stopped
+  atomic_uint stop_generation;
+  atomic_uint ponderhit_id; // Last ponder search the opponent confirmed
+
+  // Search in progress, worker thread only
+  uint32_t current_id;
+  unsigned current_generation;
+  int pondering; // Still waiting for the ponderhit
+
+  // Result mailbox, a triple buffer: the worker fills slots[back], the game
+  // thread reads slots[front], and the two swap through middle, so neither
+  // side ever waits for the other
+  worker_result_t slots[3];
+  atomic_int middle;
+  int back;
+  int front;
+} g_worker;
+
+static void post_result(const worker_result_t *result) {
+  g_worker.slots[g_worker.back] = *result;
+  int old = atomic_exchange_explicit(&g_worker.middle,
+                                     g_worker.back | MAILBOX_FRESH,
+                                     memory_order_acq_rel);
+  g_worker.back = old & ~MAILBOX_FRESH;
+}
+
+int worker_poll(worker_result_t *result) {
+  if (!(atomic_load_explicit(&g_worker.middle, memory_order_relaxed) &
+        MAILBOX_FRESH))
+    return 0;
+
+  int old = atomic_exchange_explicit(&g_worker.middle, g_worker.front,
+                                     memory_order_acq_rel);
+  g_worker.front = old & ~MAILBOX_FRESH;
+  *result = g_worker.slots[g_worker.front];
+  return 1;
+}
+
+static int stop_requested(void) {
+  return atomic_load(&g_worker.stop_generation) !=
+         g_worker.current_generation;
+}
+
+static int ponderhit_received(void) {
+  return atomic_load(&g_worker.ponderhit_id) == g_worker.current_id;
+}
+
+static void on_iteration(const search_info_t *info) {
+  // search_run clears the stop flag and sets pondering when it starts, so
+  // a stop or ponderhit that came in just before would be lost; catch them
+  // here after the first iteration
+  if (stop_requested())
+    search_stop();
+  if (g_worker.pondering && ponderhit_received()) {
+    g_worker.pondering = 0;
+    search_ponderhit();
+  }
+
+  worker_result_t result;
+  result.id = g_worker.current_id;
+  result.done = 0;
+  result.best = info->pv_length > 0 ? info->pv[0] : MOVE_NONE;
+  result.info = *info;
+  post_result(&result);
+}
+
+static void run_search(worker_command_t *command) {
+  g_worker.current_id = command->id;
+  g_worker.current_generation = command->stop_generation;
+
+  command->limits.on_iteration = on_iteration;
+  // Stopped before it started: one iteration still gives a move
+  if (stop_requested())
+    command->limits.depth = 1;
+  if (ponderhit_received())
+    command->limits.ponder = 0;
+  g_worker.pondering = command->limits.ponder;
+
+  worker_result_t result;
+  result.id = command->id;
+  result.done = 1;
+  result.best = search_run(&command->position, &command->limits,
+                           &result.info);
+
+  // A ponder search that ran out of things to do (a forced mate, say) holds
+  // its move until the opponent has actually moved
+  if (command->limits.ponder) {
+    pthread_mutex_lock(&g_worker.lock);
+    while (!ponderhit_received() && !stop_requested())
+      pthread_cond_wait(&g_worker.wake, &g_worker.lock);
+    pthread_mutex_unlock(&g_worker.lock);
+  }
+  post_result(&result);
+}
+
+static void *worker_main(void *arg) {
+  (void)arg;
+  // Too big for the frame of a short function, and only this thread uses it
+  static worker_command_t command;
+
+  for (;;) {
+    pthread_mutex_lock(&g_worker.lock);
+    while (g_worker.count == 0)
+      pthread_cond_wait(&g_worker.wake, &g_worker.lock);
+    command = g_worker.queue[g_worker.head];
+    g_worker.head = (g_worker.head + 1) % WORKER_QUEUE_SIZE;
+    g_worker.count--;
+    pthread_mutex_unlock(&g_worker.lock);
+
+    if (command.type == WORKER_CMD_QUIT)
+      break;
+    if (command.type == WORKER_CMD_NEW_GAME)
+      search_new_game();
+    else if (command.type == WORKER_CMD_SEARCH)
+      run_search(&command);
+  }
+  return NULL;
+}
+
+// Append a command to the queue and wake the worker. Returns the command's
+// ticket, 0 if the queue is full.
+static uint32_t push_command(int type, const position_t *pos,
+                             const search_limits_t *limits) {
+  uint32_t id = 0;
+
+  pthread_mutex_lock(&g_worker.lock);
+  if (g_worker.count < WORKER_QUEUE_SIZE) {
+    int tail = (g_worker.head + g_worker.count) % WORKER_QUEUE_SIZE;
+    worker_command_t *command = &g_worker.queue[tail];
+    id = ++g_worker.next_id;
+    if (id == 0)
+      id = ++g_worker.next_id; // 0 means failure
+    command->type = type;
+    command->id = id;
+    command->stop_generation = atomic_load(&g_worker.stop_generation);
+    if (pos)
+      command->position = *pos;
+    if (limits)
+      command->limits = *limits;
+    g_worker.count++;
+    pthread_cond_signal(&g_worker.wake);
+  }
+  pthread_mutex_unlock(&g_worker.lock);
+
+  if (id == 0)
+    fprintf(stderr, "Engine command queue is full\n");
+  return id;
+}
+
+uint32_t worker_search(const position_t *pos, const search_limits_t *limits) {
+  if (!g_worker.running || !pos || !limits)
+    return 0;
+  return push_command(WORKER_CMD_SEARCH, pos, limits);
+}
+
+ErrorCode worker_new_game(void) {
+  if (!g_worker.running)
+    return ERROR_INVALID_INPUT;
+  return push_command(WORKER_CMD_NEW_GAME, NULL, NULL) ? ERROR_NONE
+                                                       : ERROR_MEMORY_ALLOC;
+}
+
+void worker_stop(void) {
+  if (!g_worker.running)
+    return;
+  atomic_fetch_add(&g_worker.stop_generation, 1);
+  search_stop();
+
+  pthread_mutex_lock(&g_worker.lock);
+  pthread_cond_broadcast(&g_worker.wake);
+  pthread_mutex_unlock(&g_worker.lock);
+}
+
+void worker_ponderhit(uint32_t id) {
+  if (!g_worker.running)
+    return;
+  atomic_store(&g_worker.ponderhit_id, id);
+  search_ponderhit();
+
+  pthread_mutex_lock(&g_worker.lock);
+  pthread_cond_broadcast(&g_worker.wake);
+  pthread_mutex_unlock(&g_worker.lock);
+}
+
+ErrorCode init_worker(size_t hash_mb, int threads) {
+  ErrorCode result = search_init(hash_mb);
+  if (result != ERROR_NONE)
+    return result;
+  search_set_threads(threads);
+
+  g_worker.head = 0;
+  g_worker.count = 0;
+  g_worker.next_id = 0;
+  atomic_init(&g_worker.stop_generation, 0);
+  atomic_init(&g_worker.ponderhit_id, 0);
+  g_worker.back = 0;
+  atomic_init(&g_worker.middle, 1);
+  g_worker.front = 2;
+
+  if (pthread_mutex_init(&g_worker.lock, NULL) != 0) {
+    search_cleanup();
+    return ERROR_MEMORY_ALLOC;
+  }
+  if (pthread_cond_init(&g_worker.wake, NULL) != 0) {
+    pthread_mutex_destroy(&g_worker.lock);
+    search_cleanup();
+    return ERROR_MEMORY_ALLOC;
+  }
+  if (pthread_create(&g_worker.thread, NULL, worker_main, NULL) != 0) {
+    pthread_cond_destroy(&g_worker.wake);
+    pthread_mutex_destroy(&g_worker.lock);
+    search_cleanup();
+    return ERROR_MEMORY_ALLOC;
+  }
+
+  g_worker.running = 1;
+  return ERROR_NONE;
+}
+
+void cleanup_worker(void) {
+  if (!g_worker.running)
+    return;
+
+  // Drop whatever is still queued so the worker sees the quit right away
+  pthread_mutex_lock(&g_worker.lock);
+  g_worker.count = 0;
+  pthread_mutex_unlock(&g_worker.lock);
+  worker_stop();
+  push_command(WORKER_CMD_QUIT, NULL, NULL);
+  pthread_join(g_worker.thread, NULL);
+
+  pthread_cond_destroy(&g_worker.wake);
+  pthread_mutex_destroy(&g_worker.lock);
+  search_cleanup();
+  g_worker.running = 0;
+}
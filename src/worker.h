@@ -0,0 +1,50 @@
+#ifndef WORKER_H
+#define WORKER_H
+
+#include "config.h"
+#include "position.h"
+#include "search.h"
+#include <stddef.h>
+#include <stdint.h>
+
+// The engine runs on a worker thread of its own so a search never stalls
+// the frame loop. The game thread sends it commands through a queue and
+// polls for results once per frame; nothing on the game thread blocks on the
+// search. Every function here is meant to be called from the game thread.
+
+// Latest news from the worker. Intermediate results are posted after each
+// completed iteration; the final one has done set and best holds the move.
+typedef struct {
+  uint32_t id; // Ticket of the search this belongs to
+  int done;
+  move_t best;
+  search_info_t info;
+} worker_result_t;
+
+// Start the worker thread with a transposition table of hash_mb and threads
+// search threads
+ErrorCode init_worker(size_t hash_mb, int threads);
+void cleanup_worker(void);
+
+// Queue a search of pos (copied) and return its ticket, 0 if the queue is
+// full. limits->on_iteration is ignored; progress comes through the mailbox.
+// A ponder search posts its final result only after worker_ponderhit or
+// worker_stop, however early it finishes.
+uint32_t worker_search(const position_t *pos, const search_limits_t *limits);
+
+// Queue clearing everything learned in earlier games
+ErrorCode worker_new_game(void);
+
+// The opponent played the move the ponder search with ticket id assumed;
+// it goes on as a normal search with its limits counted from now
+void worker_ponderhit(uint32_t id);
+
+// End the running search and any queued ones at once; each still posts its
+// best move so far. Bypasses the queue.
+void worker_stop(void);
+
+// Take the most recent result if there is one the caller has not seen yet.
+// Results are overwritten rather than queued, so only the latest is kept.
+int worker_poll(worker_result_t *result);
+
+#endif // WORKER_H
@@ -0,0 +1,51 @@
+#include "zobrist.h"
+
+uint64_t zobrist_piece[COLOR_COUNT][PIECE_TYPE_COUNT][SQUARE_COUNT];
+uint64_t zobrist_castling[16];
+uint64_t zobrist_ep[8];
+uint64_t zobrist_side;
+
+// xorshift64*, good enough for hash keys and reproducible everywhere
+static uint64_t next_random(uint64_t *state) {
+  *state ^= *state >> 12;
+  *state ^= *state << 25;
+  *state ^= *state >> 27;
+  return *state * 0x2545f4914f6cdd1dULL;
+}
+
+void init_zobrist(void) {
+  static int initialized = 0;
+  if (initialized)
+    return;
+  initialized = 1;
+
+  uint64_t state = 0x9e3779b97f4a7c15ULL;
+
+  // Empty squares and NONE colors never reach the key, but get keys anyway
+  // so every index is valid
+  for (int color = 0; color < COLOR_COUNT; color++) {
+    for (int type = 0; type < PIECE_TYPE_COUNT; type++) {
+      for (int sq = 0; sq < SQUARE_COUNT; sq++) {
+        zobrist_piece[color][type][sq] = next_random(&state);
+      }
+    }
+  }
+
+  // Each castling right gets a key; a set of rights is the XOR of its members
+  uint64_t rights[4];
+  for (int i = 0; i < 4; i++) {
+    rights[i] = next_random(&state);
+  }
+  for (int mask = 0; mask < 16; mask++) {
+    zobrist_castling[mask] = 0;
+    for (int i = 0; i < 4; i++) {
+      if (mask & (1 << i))
+        zobrist_castling[mask] ^= rights[i];
+    }
+  }
+
+  for (int col = 0; col < 8; col++) {
+    zobrist_ep[col] = next_random(&state);
+  }
+  zobrist_side = next_random(&state);
+}
@@ -0,0 +1,19 @@
+#ifndef ZOBRIST_H
+#define ZOBRIST_H
+
+#include "bitboard.h"
+#include "board.h"
+#include <stdint.h>
+
+// Random keys XORed together to identify a position. Moves update a
+// position's key incrementally by toggling the keys of what changed.
+extern uint64_t zobrist_piece[COLOR_COUNT][PIECE_TYPE_COUNT][SQUARE_COUNT];
+extern uint64_t zobrist_castling[16]; // Indexed by the CASTLE_* mask
+extern uint64_t zobrist_ep[8];        // Indexed by the en passant column
+extern uint64_t zobrist_side;         // Present when black is to move
+
+// Must be called once before any key is computed. The keys come from a fixed
+// seed, so they are the same in every run.
+void init_zobrist(void);
+
+#endif // ZOBRIST_H